@@ -0,0 +1,322 @@
+//
+//  KernelBenchmarks.cpp
+//  Vortex
+//
+
+#include <Vortex/Engine/LinearSolver/GaussSeidel.h>
+#include <Vortex/Engine/LinearSolver/LinearSolver.h>
+#include <Vortex/Engine/LinearSolver/Reduce.h>
+#include <Vortex/Engine/LinearSolver/Transfer.h>
+#include <Vortex/Engine/PrefixScan.h>
+#include <Vortex/Renderer/Buffer.h>
+#include <Vortex/Renderer/CommandBuffer.h>
+#include <Vortex/Renderer/Device.h>
+#include <Vortex/Renderer/Instance.h>
+#include <Vortex/Renderer/Timer.h>
+#include <Vortex/Renderer/Work.h>
+
+#include <benchmark/benchmark.h>
+
+#include "vortex_bench_generated_spirv.h"
+
+#include <iostream>
+
+using namespace Vortex::Renderer;
+using namespace Vortex::Fluid;
+using namespace Vortex::BenchSPIRV;
+
+namespace
+{
+Device* device;
+
+/**
+ * Measures the GPU time of the recorded commands with timestamps, and reports
+ * the bandwidth from the minimum number of bytes each execution reads and
+ * writes.
+ */
+void Run(benchmark::State& state, uint64_t bytes, CommandBuffer::CommandFn commandFn)
+{
+  Timer timer(*device);
+  CommandBuffer cmd(*device);
+  cmd.Record([&](vk::CommandBuffer commandBuffer) {
+    timer.Start(commandBuffer);
+    commandFn(commandBuffer);
+    timer.Stop(commandBuffer);
+  });
+
+  for (auto _ : state)
+  {
+    cmd.Submit().Wait();
+    state.SetIterationTime(timer.GetElapsedNs() / 1e9);
+  }
+
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * bytes));
+}
+
+bool CheckLocalSize(benchmark::State& state, const glm::ivec2& localSize)
+{
+  auto limits = device->GetPhysicalDevice().getProperties().limits;
+  if (static_cast<uint32_t>(localSize.x * localSize.y) > limits.maxComputeWorkGroupInvocations)
+  {
+    state.SkipWithError("Local size larger than supported");
+    return false;
+  }
+
+  return true;
+}
+
+void Clear(std::initializer_list<std::reference_wrapper<GenericBuffer>> buffers)
+{
+  device->Execute([&](vk::CommandBuffer commandBuffer) {
+    for (auto& buffer : buffers)
+    {
+      buffer.get().Clear(commandBuffer);
+    }
+  });
+}
+
+// Arguments are the grid size and the local size.
+void SizesAndLocalSizes(benchmark::internal::Benchmark* benchmark)
+{
+  for (int size : {256, 512, 1024, 2048})
+  {
+    for (auto localSize :
+         {glm::ivec2(8, 8), glm::ivec2(16, 8), glm::ivec2(16, 16), glm::ivec2(32, 8)})
+    {
+      benchmark->Args({size, localSize.x, localSize.y});
+    }
+  }
+}
+
+// Arguments are the grid size.
+void Sizes(benchmark::internal::Benchmark* benchmark)
+{
+  for (int size : {256, 512, 1024, 2048})
+  {
+    benchmark->Args({size});
+  }
+}
+
+void BM_BufferCopy(benchmark::State& state)
+{
+  auto n = state.range(0) * state.range(0);
+  Buffer<float> input(*device, n), output(*device, n);
+  Clear({input});
+
+  Run(state, 2 * sizeof(float) * n, [&](vk::CommandBuffer commandBuffer) {
+    output.CopyFrom(commandBuffer, input);
+  });
+}
+
+void BM_Copy(benchmark::State& state)
+{
+  glm::ivec2 size(state.range(0)), localSize(state.range(1), state.range(2));
+  if (!CheckLocalSize(state, localSize))
+  {
+    return;
+  }
+
+  auto n = size.x * size.y;
+  Buffer<float> input(*device, n), output(*device, n);
+  Clear({input});
+
+  Work copy(*device, ComputeSize(size, localSize), Copy_comp);
+  auto copyBound = copy.Bind({input, output});
+
+  Run(state, 2 * sizeof(float) * n, [&](vk::CommandBuffer commandBuffer) {
+    copyBound.Record(commandBuffer);
+  });
+}
+
+void BM_MultiplyMatrix(benchmark::State& state)
+{
+  glm::ivec2 size(state.range(0)), localSize(state.range(1), state.range(2));
+  if (!CheckLocalSize(state, localSize))
+  {
+    return;
+  }
+
+  LinearSolver::Data data(*device, size);
+  Clear({data.Diagonal, data.Lower, data.X, data.B});
+
+  Work multiplyMatrix(*device, ComputeSize(size, localSize), MultiplyMatrix_comp);
+  auto multiplyMatrixBound = multiplyMatrix.Bind({data.Diagonal, data.Lower, data.X, data.B});
+
+  // reads diagonal, lower and input, writes output
+  auto n = static_cast<uint64_t>(size.x * size.y);
+  Run(state, (3 * sizeof(float) + sizeof(glm::vec2)) * n, [&](vk::CommandBuffer commandBuffer) {
+    multiplyMatrixBound.Record(commandBuffer);
+  });
+}
+
+void BM_Jacobi(benchmark::State& state)
+{
+  glm::ivec2 size(state.range(0)), localSize(state.range(1), state.range(2));
+  if (!CheckLocalSize(state, localSize))
+  {
+    return;
+  }
+
+  LinearSolver::Data data(*device, size);
+  Buffer<float> backPressure(*device, size.x * size.y);
+  Clear({data.Diagonal, data.Lower, data.X, data.B, backPressure});
+
+  Work jacobi(*device, ComputeSize(size, localSize), DampedJacobi_comp);
+  auto jacobiBound = jacobi.Bind({data.X, backPressure, data.Diagonal, data.Lower, data.B});
+
+  // reads pressure, diagonal, lower and b, writes the back pressure
+  auto n = static_cast<uint64_t>(size.x * size.y);
+  Run(state, (4 * sizeof(float) + sizeof(glm::vec2)) * n, [&](vk::CommandBuffer commandBuffer) {
+    jacobiBound.PushConstant(commandBuffer, 1.0f);
+    jacobiBound.Record(commandBuffer);
+  });
+}
+
+void BM_GaussSeidel(benchmark::State& state)
+{
+  glm::ivec2 size(state.range(0));
+
+  LinearSolver::Data data(*device, size);
+  Clear({data.Diagonal, data.Lower, data.X, data.B});
+
+  GaussSeidel gaussSeidel(*device, size);
+  gaussSeidel.SetPreconditionerIterations(1);
+  gaussSeidel.Bind(data.Diagonal, data.Lower, data.B, data.X);
+
+  // one red and black iteration, reads pressure, diagonal, lower and b,
+  // writes pressure
+  Preconditioner& preconditioner = gaussSeidel;
+  auto n = static_cast<uint64_t>(size.x * size.y);
+  Run(state, (4 * sizeof(float) + sizeof(glm::vec2)) * n, [&](vk::CommandBuffer commandBuffer) {
+    preconditioner.Record(commandBuffer);
+  });
+}
+
+void BM_LocalGaussSeidel(benchmark::State& state)
+{
+  // solved in a single work group
+  glm::ivec2 size(state.range(0));
+
+  LinearSolver::Data data(*device, size);
+  Clear({data.Diagonal, data.Lower, data.X, data.B});
+
+  LocalGaussSeidel localGaussSeidel(*device, size);
+  localGaussSeidel.Bind(data.Diagonal, data.Lower, data.B, data.X);
+
+  // reads diagonal, lower and b, writes pressure
+  Preconditioner& preconditioner = localGaussSeidel;
+  auto n = static_cast<uint64_t>(size.x * size.y);
+  Run(state, (3 * sizeof(float) + sizeof(glm::vec2)) * n, [&](vk::CommandBuffer commandBuffer) {
+    preconditioner.Record(commandBuffer);
+  });
+}
+
+void BM_Restrict(benchmark::State& state)
+{
+  glm::ivec2 fineSize(state.range(0)), coarseSize(state.range(0) / 2);
+
+  auto fineN = static_cast<uint64_t>(fineSize.x * fineSize.y);
+  auto coarseN = static_cast<uint64_t>(coarseSize.x * coarseSize.y);
+  Buffer<float> fine(*device, fineN), fineDiagonal(*device, fineN);
+  Buffer<float> coarse(*device, coarseN), coarseDiagonal(*device, coarseN);
+  Clear({fine, fineDiagonal, coarseDiagonal});
+
+  Transfer transfer(*device);
+  transfer.RestrictBind(0, fineSize, fine, fineDiagonal, coarse, coarseDiagonal);
+
+  // reads the fine level and diagonals, writes the coarse level
+  Run(state, (2 * fineN + 2 * coarseN) * sizeof(float), [&](vk::CommandBuffer commandBuffer) {
+    transfer.Restrict(commandBuffer, 0);
+  });
+}
+
+void BM_Prolongate(benchmark::State& state)
+{
+  glm::ivec2 fineSize(state.range(0)), coarseSize(state.range(0) / 2);
+
+  auto fineN = static_cast<uint64_t>(fineSize.x * fineSize.y);
+  auto coarseN = static_cast<uint64_t>(coarseSize.x * coarseSize.y);
+  Buffer<float> fine(*device, fineN), fineDiagonal(*device, fineN);
+  Buffer<float> coarse(*device, coarseN), coarseDiagonal(*device, coarseN);
+  Clear({coarse, fineDiagonal, coarseDiagonal});
+
+  Transfer transfer(*device);
+  transfer.ProlongateBind(0, fineSize, fine, fineDiagonal, coarse, coarseDiagonal);
+
+  // reads the coarse level and diagonals, writes the fine level
+  Run(state, (2 * fineN + 2 * coarseN) * sizeof(float), [&](vk::CommandBuffer commandBuffer) {
+    transfer.Prolongate(commandBuffer, 0);
+  });
+}
+
+template <typename ReduceType, typename Type>
+void BM_Reduce(benchmark::State& state)
+{
+  glm::ivec2 size(state.range(0));
+
+  auto n = static_cast<uint64_t>(size.x * size.y);
+  Buffer<Type> input(*device, n), output(*device, 1);
+  Clear({input});
+
+  ReduceType reduce(*device, size);
+  auto reduceBound = reduce.Bind(input, output);
+
+  Run(state, sizeof(Type) * n, [&](vk::CommandBuffer commandBuffer) {
+    reduceBound.Record(commandBuffer);
+  });
+}
+
+void BM_PrefixScan(benchmark::State& state)
+{
+  auto n = static_cast<int>(state.range(0) * state.range(0));
+
+  Buffer<int> input(*device, n), output(*device, n);
+  Buffer<DispatchParams> dispatchParams(*device, 1);
+  Clear({input});
+
+  PrefixScan prefixScan(*device, n);
+  auto prefixScanBound = prefixScan.Bind(input, output, dispatchParams);
+
+  Run(state, 2 * sizeof(int) * n, [&](vk::CommandBuffer commandBuffer) {
+    prefixScanBound.Record(commandBuffer);
+  });
+}
+
+}  // namespace
+
+// Baselines
+BENCHMARK(BM_BufferCopy)->Apply(Sizes)->UseManualTime();
+BENCHMARK(BM_Copy)->Apply(SizesAndLocalSizes)->UseManualTime();
+
+// Solver primitives
+BENCHMARK(BM_MultiplyMatrix)->Apply(SizesAndLocalSizes)->UseManualTime();
+BENCHMARK(BM_Jacobi)->Apply(SizesAndLocalSizes)->UseManualTime();
+BENCHMARK(BM_GaussSeidel)->Apply(Sizes)->UseManualTime();
+BENCHMARK(BM_LocalGaussSeidel)->Arg(16)->UseManualTime();
+BENCHMARK(BM_Restrict)->Apply(Sizes)->UseManualTime();
+BENCHMARK(BM_Prolongate)->Apply(Sizes)->UseManualTime();
+
+// Reductions and scan
+BENCHMARK_TEMPLATE(BM_Reduce, ReduceSum, float)->Apply(Sizes)->UseManualTime();
+BENCHMARK_TEMPLATE(BM_Reduce, ReduceMax, float)->Apply(Sizes)->UseManualTime();
+BENCHMARK_TEMPLATE(BM_Reduce, ReduceJ, glm::vec4)->Apply(Sizes)->UseManualTime();
+BENCHMARK(BM_PrefixScan)->Apply(Sizes)->UseManualTime();
+
+int main(int argc, char** argv)
+{
+  Instance instance("Vortex2D Kernel Bench", {}, false);
+  Device device_(instance, false);
+
+  if (!device_.GetPhysicalDevice().getProperties().limits.timestampComputeAndGraphics)
+  {
+    std::cerr << "Device does not support timestamps" << std::endl;
+    return 1;
+  }
+
+  device = &device_;
+
+  benchmark::Initialize(&argc, argv);
+  benchmark::RunSpecifiedBenchmarks();
+
+  return 0;
+}
@@ -0,0 +1,135 @@
+//
+//  Scenes.h
+//  Vortex
+//
+
+#pragma once
+
+#include <Vortex/Vortex.h>
+
+/**
+ * @brief A scene modelled on the examples, without any rendering to a window.
+ * The positions and sizes of the examples are scaled to the grid size.
+ */
+class Scene
+{
+public:
+  virtual ~Scene() {}
+  virtual void Step(Vortex::Fluid::LinearSolver::Parameters& params) = 0;
+};
+
+class SmokeScene : public Scene
+{
+public:
+  SmokeScene(const Vortex::Renderer::Device& device, const glm::ivec2& size, float dt)
+      : scale(glm::vec2(size) / glm::vec2(256.0f))
+      , source1(device, scale * glm::vec2(20.0f))
+      , source2(device, scale * glm::vec2(20.0f))
+      , force1(device, scale * glm::vec2(20.0f))
+      , force2(device, scale * glm::vec2(20.0f))
+      , density(device, size, vk::Format::eR8G8B8A8Unorm)
+      , world(device, size, dt, Vortex::Fluid::Velocity::InterpolationMode::Linear)
+  {
+    world.FieldBind(density);
+
+    source1.Position = force1.Position = scale * glm::vec2(75.0f, 25.0f);
+    source2.Position = force2.Position = scale * glm::vec2(175.0f, 225.0f);
+
+    source1.Anchor = source2.Anchor = scale * glm::vec2(10.0);
+    force1.Anchor = force2.Anchor = scale * glm::vec2(10.0);
+
+    source1.Colour = source2.Colour = glm::vec4(0.3f, 0.3f, 0.3f, 1.0f);
+
+    force1.Colour = {0.0f, 30.0f, 0.0f, 0.0f};
+    force2.Colour = {0.0f, -30.0f, 0.0f, 0.0f};
+
+    // Draw liquid boundaries
+    Vortex::Renderer::Rectangle area(device, glm::vec2(size) - glm::vec2(4.0f));
+    area.Colour = glm::vec4(-1);
+    area.Position = glm::vec2(2.0f);
+
+    Vortex::Renderer::Clear clearLiquid({1.0f, 0.0f, 0.0f, 0.0f});
+
+    world.RecordLiquidPhi({clearLiquid, area}).Submit().Wait();
+
+    // Draw solid boundaries
+    Vortex::Fluid::Circle obstacle1(device, scale.x * 15.0f);
+    Vortex::Fluid::Circle obstacle2(device, scale.x * 15.0f);
+
+    obstacle1.Position = scale * glm::vec2(75.0f, 100.0f);
+    obstacle2.Position = scale * glm::vec2(175.0f, 125.0f);
+
+    world.RecordStaticSolidPhi({Vortex::Fluid::BoundariesClear, obstacle1, obstacle2})
+        .Submit()
+        .Wait();
+
+    // Draw sources and forces
+    velocityRender = world.RecordVelocity({force1, force2}, Vortex::Fluid::VelocityOp::Set);
+    densityRender = density.Record({source1, source2});
+  }
+
+  void Step(Vortex::Fluid::LinearSolver::Parameters& params) override
+  {
+    velocityRender.Submit();
+    densityRender.Submit();
+
+    world.Step(params);
+  }
+
+private:
+  glm::vec2 scale;
+  Vortex::Renderer::Rectangle source1, source2;
+  Vortex::Renderer::Rectangle force1, force2;
+  Vortex::Fluid::Density density;
+  Vortex::Fluid::SmokeWorld world;
+  Vortex::Renderer::RenderCommand velocityRender, densityRender;
+};
+
+class WaterScene : public Scene
+{
+public:
+  WaterScene(const Vortex::Renderer::Device& device, const glm::ivec2& size, float dt)
+      : scale(glm::vec2(size) / glm::vec2(256.0f))
+      , gravity(device, glm::vec2(size))
+      , world(device, size, dt, 2, Vortex::Fluid::Velocity::InterpolationMode::Linear)
+  {
+    gravity.Colour = {0.0f, 3.0f, 0.0f, 0.0f};
+
+    // Add particles
+    Vortex::Renderer::IntRectangle fluid(device, scale * glm::vec2(150.0f, 50.0f));
+    fluid.Position = scale * glm::vec2(50.0f, 25.0f);
+    fluid.Colour = glm::vec4(4);
+
+    world.RecordParticleCount({fluid}).Submit().Wait();
+
+    // Draw solid boundaries
+    Vortex::Fluid::Rectangle obstacle1(device, scale * glm::vec2(50.0f, 25.0f));
+    Vortex::Fluid::Rectangle obstacle2(device, scale * glm::vec2(50.0f, 25.0f));
+    Vortex::Fluid::Rectangle area(device, scale * glm::vec2(250.0f), true, 5.0f);
+
+    area.Position = scale * glm::vec2(3.0f);
+
+    obstacle1.Position = scale * glm::vec2(75.0f, 150.0f);
+    obstacle1.Rotation = 45.0f;
+
+    obstacle2.Position = scale * glm::vec2(150.0f, 150.0f);
+    obstacle2.Rotation = 30.0f;
+
+    world.RecordStaticSolidPhi({area, obstacle1, obstacle2}).Submit().Wait();
+
+    // Set gravity
+    velocityRender = world.RecordVelocity({gravity}, Vortex::Fluid::VelocityOp::Add);
+  }
+
+  void Step(Vortex::Fluid::LinearSolver::Parameters& params) override
+  {
+    world.SubmitVelocity(velocityRender);
+    world.Step(params);
+  }
+
+private:
+  glm::vec2 scale;
+  Vortex::Renderer::Rectangle gravity;
+  Vortex::Fluid::WaterWorld world;
+  Vortex::Renderer::RenderCommand velocityRender;
+};
@@ -0,0 +1,245 @@
+//
+//  main.cpp
+//  Vortex
+//
+
+#include <Vortex/Renderer/Profiler.h>
+#include <Vortex/Vortex.h>
+
+#include "Scenes.h"
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace Vortex;
+
+namespace
+{
+const float delta = 0.016f;
+
+struct Options
+{
+  std::vector<std::string> Scenes = {"smoke", "water"};
+  std::vector<int> Sizes = {128, 256, 512, 1024, 2048};
+  unsigned Steps = 100;
+  unsigned Warmup = 5;
+  std::string Output;
+  std::string LocalSizes;
+};
+
+struct Solver
+{
+  std::string Name;
+  Fluid::LinearSolver::Parameters Params;
+};
+
+std::vector<std::string> Split(const std::string& value)
+{
+  std::vector<std::string> values;
+  std::stringstream stream(value);
+  std::string item;
+  while (std::getline(stream, item, ','))
+  {
+    values.push_back(item);
+  }
+
+  return values;
+}
+
+Options ParseOptions(int argc, char** argv)
+{
+  Options options;
+  for (int i = 1; i < argc; i++)
+  {
+    std::string option = argv[i];
+    if (i + 1 == argc)
+    {
+      throw std::runtime_error("Missing value for " + option);
+    }
+
+    std::string value = argv[++i];
+    if (option == "--scenes")
+    {
+      options.Scenes = Split(value);
+    }
+    else if (option == "--sizes")
+    {
+      options.Sizes.clear();
+      for (auto& size : Split(value))
+      {
+        options.Sizes.push_back(std::stoi(size));
+      }
+    }
+    else if (option == "--steps")
+    {
+      options.Steps = static_cast<unsigned>(std::stoul(value));
+    }
+    else if (option == "--warmup")
+    {
+      options.Warmup = static_cast<unsigned>(std::stoul(value));
+    }
+    else if (option == "--output")
+    {
+      options.Output = value;
+    }
+    else if (option == "--local-sizes")
+    {
+      options.LocalSizes = value;
+    }
+    else
+    {
+      throw std::runtime_error("Unknown option " + option);
+    }
+  }
+
+  return options;
+}
+
+std::unique_ptr<Scene> CreateScene(const Renderer::Device& device,
+                                   const std::string& name,
+                                   const glm::ivec2& size)
+{
+  if (name == "smoke")
+  {
+    return std::unique_ptr<Scene>(new SmokeScene(device, size, delta));
+  }
+  else if (name == "water")
+  {
+    return std::unique_ptr<Scene>(new WaterScene(device, size, delta));
+  }
+
+  throw std::runtime_error("Unknown scene " + name);
+}
+
+void Run(const Renderer::Device& device,
+         const std::string& sceneName,
+         int size,
+         Solver& solver,
+         const Options& options,
+         std::ostream& out)
+{
+  // the profiler needs to exist before the scene records its command buffers
+  std::unique_ptr<Renderer::Profiler> profiler;
+  if (device.GetPhysicalDevice().getProperties().limits.timestampComputeAndGraphics)
+  {
+    profiler.reset(new Renderer::Profiler(device));
+  }
+
+  auto scene = CreateScene(device, sceneName, glm::ivec2(size));
+
+  for (unsigned i = 0; i < options.Warmup; i++)
+  {
+    scene->Step(solver.Params);
+  }
+
+  device.Handle().waitIdle();
+
+  uint64_t iterations = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (unsigned i = 0; i < options.Steps; i++)
+  {
+    scene->Step(solver.Params);
+    iterations += solver.Params.OutIterations;
+  }
+
+  device.Handle().waitIdle();
+  auto end = std::chrono::steady_clock::now();
+
+  double seconds = std::chrono::duration<double>(end - start).count();
+
+  VmaStats stats;
+  vmaCalculateStats(device.Allocator(), &stats);
+
+  out << "    {\"scene\": \"" << sceneName << "\", \"size\": " << size << ", \"solver\": \""
+      << solver.Name << "\",\n";
+  out << "     \"steps_per_second\": " << options.Steps / seconds
+      << ", \"iterations\": " << static_cast<double>(iterations) / options.Steps
+      << ", \"memory_bytes\": " << stats.total.usedBytes << ",\n";
+
+  // GPU time of the last execution of each stage
+  out << "     \"stages\": [";
+  if (profiler)
+  {
+    auto stages = profiler->Resolve();
+    for (std::size_t i = 0; i < stages.size(); i++)
+    {
+      out << (i == 0 ? "\n" : ",\n") << "       {\"name\": \"" << stages[i].Name
+          << "\", \"depth\": " << stages[i].Depth << ", \"count\": " << stages[i].Count
+          << ", \"gpu_ms\": " << stages[i].LastExecutionNs / 1e6 << "}";
+    }
+  }
+  out << "]}";
+}
+
+}  // namespace
+
+int main(int argc, char** argv)
+{
+  try
+  {
+    auto options = ParseOptions(argc, argv);
+
+    // no window, so the benchmarks can also run on a software vulkan driver
+    Renderer::Instance instance("Vortex2D Bench", {}, false);
+    Renderer::Device device(instance, false);
+
+    // the local sizes missing from the file are tuned on the scenes' fields,
+    // which are overwritten, so only the following runs give valid results.
+    if (!options.LocalSizes.empty())
+    {
+      device.GetLocalSizeTuner().Load(options.LocalSizes);
+      device.GetLocalSizeTuner().SetTuning(true);
+    }
+
+    std::vector<Solver> solvers = {{"fixed", Fluid::FixedParams(12)},
+                                   {"iterative", Fluid::IterativeParams(1e-3f)}};
+
+    std::ofstream file;
+    if (!options.Output.empty())
+    {
+      file.open(options.Output, std::ios::trunc);
+      if (!file)
+      {
+        throw std::runtime_error("Cannot open output file " + options.Output);
+      }
+    }
+
+    std::ostream& out = options.Output.empty() ? std::cout : file;
+
+    auto properties = device.GetPhysicalDevice().getProperties();
+    out << "{\n  \"device\": \"" << properties.deviceName << "\",\n";
+    out << "  \"steps\": " << options.Steps << ",\n";
+    out << "  \"results\": [";
+
+    bool first = true;
+    for (auto& sceneName : options.Scenes)
+    {
+      for (auto size : options.Sizes)
+      {
+        for (auto& solver : solvers)
+        {
+          std::cerr << "Running " << sceneName << " " << size << "x" << size << " "
+                    << solver.Name << std::endl;
+
+          out << (first ? "\n" : ",\n");
+          Run(device, sceneName, size, solver, options, out);
+          first = false;
+        }
+      }
+    }
+
+    out << "\n  ]\n}" << std::endl;
+  }
+  catch (const std::exception& error)
+  {
+    std::cerr << "exception: " << error.what() << std::endl;
+    return 1;
+  }
+
+  return 0;
+}
@@ -85,7 +85,7 @@ public:
       : glfwWindow(GetGLFWWindow(windowSize))
       , instance("Vortex2D", GetGLFWExtensions(), validation)
       , surface(GetGLFWSurface(glfwWindow, static_cast<VkInstance>(instance.GetInstance())))
-      , device(instance, *surface, validation)
+      , device(instance, *surface, validation, "vortex2d_pipeline_cache.bin")
       , window(device, *surface, (uint32_t)(windowSize.x), (uint32_t)(windowSize.y))
       , clearRender(window.Record({clear}))
   {
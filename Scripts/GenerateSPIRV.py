@@ -9,6 +9,7 @@ parser.add_argument('files', metavar='files', nargs='+', help='list of glsl file
 parser.add_argument('--output', action='store', dest='output', help='output file')
 parser.add_argument('--compiler', action='store', dest='compiler', help='location of spirv compiler')
 parser.add_argument('--vulkan_version', action='store', dest='version', help='vulkan version')
+parser.add_argument('--namespace', action='store', dest='namespace', default='SPIRV', help='namespace of the binaries')
 
 args = parser.parse_args()
 
@@ -48,9 +49,8 @@ namespace Renderer
 class SpirvBinary;
 }
 
-namespace SPIRV
-{
 ''')
+  f.write('namespace ' + args.namespace + '\n{\n')
 
   for file in args.files:
     f.write(genCArrayDef(file))
@@ -73,9 +73,8 @@ with open(args.output + '.cpp', 'w') as f:
 
 namespace Vortex
 {
-namespace SPIRV
-{
 ''')
+  f.write('namespace ' + args.namespace + '\n{\n')
 
   for file in args.files:
     f.write(genCArray(file))
@@ -9,11 +9,131 @@
 #include "VariationalHelpers.h"
 #include "Verify.h"
 
+#include <algorithm>
+#include <memory>
+
 using namespace Vortex::Renderer;
 using namespace Vortex::Fluid;
 
 extern Device* device;
 
+void SetVelocityData(Velocity& velocity, const std::vector<glm::vec2>& data)
+{
+  Texture input(*device,
+                velocity.GetWidth(),
+                velocity.GetHeight(),
+                vk::Format::eR32G32Sfloat,
+                VMA_MEMORY_USAGE_CPU_ONLY);
+  input.CopyFrom(data);
+
+  device->Execute(
+      [&](vk::CommandBuffer commandBuffer) { velocity.CopyFrom(commandBuffer, input); });
+}
+
+std::vector<glm::vec2> GetVelocityData(Velocity& velocity)
+{
+  Texture output(*device,
+                 velocity.GetWidth(),
+                 velocity.GetHeight(),
+                 vk::Format::eR32G32Sfloat,
+                 VMA_MEMORY_USAGE_CPU_ONLY);
+
+  device->Execute(
+      [&](vk::CommandBuffer commandBuffer) { output.CopyFrom(commandBuffer, velocity); });
+
+  std::vector<glm::vec2> data(output.GetWidth() * output.GetHeight());
+  output.CopyTo(data);
+  return data;
+}
+
+void SetFieldData(Density& field, const std::vector<glm::u8vec4>& data)
+{
+  Texture input(*device,
+                field.GetWidth(),
+                field.GetHeight(),
+                vk::Format::eB8G8R8A8Unorm,
+                VMA_MEMORY_USAGE_CPU_ONLY);
+  input.CopyFrom(data);
+
+  device->Execute([&](vk::CommandBuffer commandBuffer) { field.CopyFrom(commandBuffer, input); });
+}
+
+std::vector<glm::u8vec4> GetFieldData(Density& field)
+{
+  Texture output(*device,
+                 field.GetWidth(),
+                 field.GetHeight(),
+                 vk::Format::eB8G8R8A8Unorm,
+                 VMA_MEMORY_USAGE_CPU_ONLY);
+
+  device->Execute([&](vk::CommandBuffer commandBuffer) { output.CopyFrom(commandBuffer, field); });
+
+  std::vector<glm::u8vec4> data(output.GetWidth() * output.GetHeight());
+  output.CopyTo(data);
+  return data;
+}
+
+// advects a single dot at pos with a uniform velocity, and returns the field
+std::vector<glm::u8vec4> AdvectDot(const glm::ivec2& size,
+                                   const glm::vec2& vel,
+                                   const glm::ivec2& pos,
+                                   Velocity::InterpolationMode interpolationMode)
+{
+  Velocity velocity(*device, size);
+  SetVelocityData(velocity, std::vector<glm::vec2>(size.x * size.y, vel / glm::vec2(size)));
+
+  Density field(*device, size, vk::Format::eB8G8R8A8Unorm);
+  std::vector<glm::u8vec4> fieldData(size.x * size.y);
+  fieldData[pos.x + size.x * pos.y].x = 128;
+  SetFieldData(field, fieldData);
+
+  Advection advection(*device, size, 1.0f, velocity, interpolationMode);
+  advection.AdvectBind(field);
+  advection.Advect();
+
+  device->Handle().waitIdle();
+
+  return GetFieldData(field);
+}
+
+// same as the trace of CommonAdvect.comp, with the linear interpolation
+glm::vec2 Trace(const glm::ivec2& size,
+                const std::vector<glm::vec2>& velocity,
+                const glm::vec2& pos,
+                float delta,
+                Advection::Integrator integrator)
+{
+  auto interpolate = [&](const glm::vec2& xy, int component) {
+    glm::ivec2 ij(glm::floor(xy));
+    glm::vec2 f = xy - glm::vec2(ij);
+    auto value = [&](int i, int j) { return velocity[ij.x + i + size.x * (ij.y + j)][component]; };
+
+    return glm::mix(
+        glm::mix(value(0, 0), value(1, 0), f.x), glm::mix(value(0, 1), value(1, 1), f.x), f.y);
+  };
+
+  auto getVelocity = [&](const glm::vec2& xy) {
+    return glm::vec2(interpolate(xy - glm::vec2(0.0f, 0.5f), 0),
+                     interpolate(xy - glm::vec2(0.5f, 0.0f), 1));
+  };
+
+  float d = size.x * delta;
+  glm::vec2 k1 = getVelocity(pos);
+  if (integrator == Advection::Integrator::Euler)
+  {
+    return pos - d * k1;
+  }
+
+  glm::vec2 k2 = getVelocity(pos - 0.5f * d * k1);
+  if (integrator == Advection::Integrator::RK2)
+  {
+    return pos - d * k2;
+  }
+
+  glm::vec2 k3 = getVelocity(pos - 0.75f * d * k2);
+  return pos - (2.0f / 9.0f) * d * k1 - (3.0f / 9.0f) * d * k2 - (4.0f / 9.0f) * d * k3;
+}
+
 TEST(AdvectionTests, AdvectVelocity_Simple)
 {
   glm::ivec2 size(50);
@@ -72,43 +192,293 @@ TEST(AdvectionTests, Advect)
   glm::vec2 vel(3.0f, 1.0f);
   glm::ivec2 pos(3, 4);
 
-  Texture velocityInput(
-      *device, size.x, size.y, vk::Format::eR32G32Sfloat, VMA_MEMORY_USAGE_CPU_ONLY);
-  Velocity velocity(*device, size);
+  auto pixels = AdvectDot(size, vel, pos, Velocity::InterpolationMode::Cubic);
 
-  std::vector<glm::vec2> velocityData(size.x * size.y, vel / glm::vec2(size));
-  velocityInput.CopyFrom(velocityData);
+  pos += glm::ivec2(vel);
+  ASSERT_EQ(128, pixels[pos.x + size.x * pos.y].x);
+}
 
-  device->Execute(
-      [&](vk::CommandBuffer commandBuffer) { velocity.CopyFrom(commandBuffer, velocityInput); });
+TEST(AdvectionTests, AdvectBindUnbind)
+{
+  glm::ivec2 size(10);
 
-  Texture fieldInput(
-      *device, size.x, size.y, vk::Format::eB8G8R8A8Unorm, VMA_MEMORY_USAGE_CPU_ONLY);
-  Density field(*device, size, vk::Format::eB8G8R8A8Unorm);
+  glm::vec2 vel(3.0f, 1.0f);
+  glm::ivec2 pos(3, 4);
 
+  Velocity velocity(*device, size);
+  SetVelocityData(velocity, std::vector<glm::vec2>(size.x * size.y, vel / glm::vec2(size)));
+
+  Density field(*device, size, vk::Format::eB8G8R8A8Unorm);
   std::vector<glm::u8vec4> fieldData(size.x * size.y);
   fieldData[pos.x + size.x * pos.y].x = 128;
-  fieldInput.CopyFrom(fieldData);
-
-  device->Execute(
-      [&](vk::CommandBuffer commandBuffer) { field.CopyFrom(commandBuffer, fieldInput); });
+  SetFieldData(field, fieldData);
 
   Advection advection(*device, size, 1.0f, velocity, Velocity::InterpolationMode::Cubic);
+  // binding twice advects once
+  advection.AdvectBind(field);
   advection.AdvectBind(field);
   advection.Advect();
 
   device->Handle().waitIdle();
 
+  auto pixels = GetFieldData(field);
+
+  pos += glm::ivec2(vel);
+  ASSERT_EQ(128, pixels[pos.x + size.x * pos.y].x);
+
+  // an unbound field is not advected
+  advection.AdvectUnbind(field);
+  advection.Advect();
+
+  device->Handle().waitIdle();
+
+  pixels = GetFieldData(field);
+  ASSERT_EQ(128, pixels[pos.x + size.x * pos.y].x);
+}
+
+TEST(AdvectionTests, AdvectIntegrators)
+{
+  glm::ivec2 size(20);
+
+  // rotating velocity field, on which the integrators give different traces
+  std::vector<glm::vec2> velocityData(size.x * size.y);
+  for (int i = 0; i < size.x; i++)
+  {
+    for (int j = 0; j < size.y; j++)
+    {
+      velocityData[i + size.x * j] =
+          0.3f * glm::vec2(j - size.y / 2, size.x / 2 - i) / glm::vec2(size);
+    }
+  }
+
+  Velocity velocity(*device, size);
+  SetVelocityData(velocity, velocityData);
+
+  // no solid, the particles are not projected
+  Texture solidPhiInput(*device, size.x, size.y, vk::Format::eR32Sfloat, VMA_MEMORY_USAGE_CPU_ONLY);
+  Texture solidPhi(*device, size.x, size.y, vk::Format::eR32Sfloat);
+  solidPhiInput.CopyFrom(std::vector<float>(size.x * size.y, 100.0f));
   device->Execute(
-      [&](vk::CommandBuffer commandBuffer) { fieldInput.CopyFrom(commandBuffer, field); });
+      [&](vk::CommandBuffer commandBuffer) { solidPhi.CopyFrom(commandBuffer, solidPhiInput); });
+
+  // particles close enough to the center to be traced inside the grid
+  std::vector<Particle> particlesData;
+  for (int i = 7; i < 13; i++)
+  {
+    for (int j = 7; j < 13; j++)
+    {
+      Particle particle;
+      particle.Position = glm::vec2(i + 0.25f, j + 0.75f);
+      particlesData.push_back(particle);
+    }
+  }
+
+  float dt = 1.0f;
+  std::vector<std::vector<glm::vec2>> traces;
+  for (auto integrator : {Advection::Integrator::Euler,
+                          Advection::Integrator::RK2,
+                          Advection::Integrator::RK3})
+  {
+    Buffer<Particle> particles(*device, particlesData.size(), VMA_MEMORY_USAGE_CPU_ONLY);
+    IndirectBuffer<DispatchParams> dispatchParams(*device, VMA_MEMORY_USAGE_CPU_ONLY);
+
+    CopyFrom(dispatchParams, DispatchParams(static_cast<int32_t>(particlesData.size())));
+    CopyFrom(particles, particlesData);
+
+    Advection advection(
+        *device, size, dt, velocity, Velocity::InterpolationMode::Linear, integrator);
+    advection.AdvectParticleBind(particles, solidPhi, dispatchParams);
+    advection.AdvectParticles();
+    device->Handle().waitIdle();
+
+    std::vector<Particle> outParticlesData(particlesData.size());
+    CopyTo(particles, outParticlesData);
 
-  std::vector<glm::u8vec4> pixels(fieldInput.GetWidth() * fieldInput.GetHeight());
-  fieldInput.CopyTo(pixels);
+    std::vector<glm::vec2> trace;
+    for (std::size_t i = 0; i < particlesData.size(); i++)
+    {
+      // particles are traced forward
+      auto pos = Trace(size, velocityData, particlesData[i].Position, -dt, integrator);
+
+      EXPECT_NEAR(pos.x, outParticlesData[i].Position.x, 1e-4f);
+      EXPECT_NEAR(pos.y, outParticlesData[i].Position.y, 1e-4f);
+
+      trace.push_back(outParticlesData[i].Position);
+    }
+
+    traces.push_back(trace);
+  }
+
+  // the spec constant selects a different integrator each time
+  auto maxDifference = [&](std::size_t a, std::size_t b) {
+    float difference = 0.0f;
+    for (std::size_t i = 0; i < particlesData.size(); i++)
+    {
+      difference = std::max(difference, glm::length(traces[a][i] - traces[b][i]));
+    }
+    return difference;
+  };
+
+  EXPECT_GT(maxDifference(0, 1), 1e-2f);
+  EXPECT_GT(maxDifference(1, 2), 1e-3f);
+  EXPECT_GT(maxDifference(0, 2), 1e-2f);
+}
+
+TEST(AdvectionTests, AdvectLinearSampler)
+{
+  glm::ivec2 size(10);
+
+  glm::vec2 vel(3.0f, 1.0f);
+  glm::ivec2 pos(3, 4);
+
+  auto pixels = AdvectDot(size, vel, pos, Velocity::InterpolationMode::LinearSampler);
 
   pos += glm::ivec2(vel);
   ASSERT_EQ(128, pixels[pos.x + size.x * pos.y].x);
 }
 
+TEST(AdvectionTests, AdvectCubicSampler)
+{
+  glm::ivec2 size(10);
+
+  glm::vec2 vel(2.3f, 1.6f);
+
+  Velocity velocity(*device, size);
+  SetVelocityData(velocity, std::vector<glm::vec2>(size.x * size.y, vel / glm::vec2(size)));
+
+  // smooth field, so the limited precision of the hardware filtering stays small
+  Density field(*device, size, vk::Format::eB8G8R8A8Unorm);
+  std::vector<glm::u8vec4> fieldData(size.x * size.y);
+  for (int i = 0; i < size.x; i++)
+  {
+    for (int j = 0; j < size.y; j++)
+    {
+      fieldData[i + size.x * j].x = static_cast<uint8_t>(4 * i + j * j);
+    }
+  }
+  SetFieldData(field, fieldData);
+
+  Advection advection(*device, size, 1.0f, velocity, Velocity::InterpolationMode::CubicSampler);
+  advection.AdvectBind(field);
+  advection.Advect();
+
+  device->Handle().waitIdle();
+
+  auto pixels = GetFieldData(field);
+
+  // cubic b-spline weights, with the texels clamped to the edge
+  auto weights = [](float f) {
+    return glm::vec4((1.0f - 3.0f * f + 3.0f * f * f - f * f * f) / 6.0f,
+                     (4.0f - 6.0f * f * f + 3.0f * f * f * f) / 6.0f,
+                     (1.0f + 3.0f * f + 3.0f * f * f - 3.0f * f * f * f) / 6.0f,
+                     f * f * f / 6.0f);
+  };
+
+  for (int i = 0; i < size.x; i++)
+  {
+    for (int j = 0; j < size.y; j++)
+    {
+      glm::vec2 xy = glm::vec2(i, j) - vel;
+      glm::vec2 index = glm::floor(xy);
+      glm::vec4 wx = weights(xy.x - index.x);
+      glm::vec4 wy = weights(xy.y - index.y);
+
+      float expected = 0.0f;
+      for (int k = 0; k < 4; k++)
+      {
+        for (int l = 0; l < 4; l++)
+        {
+          int x = glm::clamp(static_cast<int>(index.x) + k - 1, 0, size.x - 1);
+          int y = glm::clamp(static_cast<int>(index.y) + l - 1, 0, size.y - 1);
+          expected += wx[k] * wy[l] * fieldData[x + size.x * y].x;
+        }
+      }
+
+      EXPECT_NEAR(expected, pixels[i + size.x * j].x, 2.0f);
+    }
+  }
+}
+
+TEST(AdvectionTests, AdvectVelocity_LinearSampler)
+{
+  glm::ivec2 size(20);
+
+  // rotating velocity field, moving less than a cell
+  std::vector<glm::vec2> velocityData(size.x * size.y);
+  for (int i = 0; i < size.x; i++)
+  {
+    for (int j = 0; j < size.y; j++)
+    {
+      velocityData[i + size.x * j] = 0.01f * glm::vec2(j - size.y / 2, size.x / 2 - i);
+    }
+  }
+
+  Velocity velocity(*device, size);
+  SetVelocityData(velocity, velocityData);
+
+  Velocity velocitySampler(*device, size);
+  SetVelocityData(velocitySampler, velocityData);
+
+  Advection advection(*device, size, 0.1f, velocity, Velocity::InterpolationMode::Linear);
+  advection.AdvectVelocity();
+
+  Advection advectionSampler(
+      *device, size, 0.1f, velocitySampler, Velocity::InterpolationMode::LinearSampler);
+  advectionSampler.AdvectVelocity();
+
+  device->Handle().waitIdle();
+
+  auto expected = GetVelocityData(velocity);
+  auto pixels = GetVelocityData(velocitySampler);
+
+  // the sampler clamps to the edge, so only the interior is the same
+  for (int i = 2; i < size.x - 2; i++)
+  {
+    for (int j = 2; j < size.y - 2; j++)
+    {
+      std::size_t index = i + size.x * j;
+      EXPECT_NEAR(expected[index].x, pixels[index].x, 1e-3f);
+      EXPECT_NEAR(expected[index].y, pixels[index].y, 1e-3f);
+    }
+  }
+}
+
+TEST(AdvectionTests, AdvectMultiple)
+{
+  glm::ivec2 size(10);
+
+  glm::vec2 vel(3.0f, 1.0f);
+
+  Velocity velocity(*device, size);
+  SetVelocityData(velocity, std::vector<glm::vec2>(size.x * size.y, vel / glm::vec2(size)));
+
+  // more fields than advected in one dispatch
+  Advection advection(*device, size, 1.0f, velocity, Velocity::InterpolationMode::Cubic);
+  std::vector<std::unique_ptr<Density>> fields;
+  for (int i = 0; i < 6; i++)
+  {
+    fields.emplace_back(new Density(*device, size, vk::Format::eB8G8R8A8Unorm));
+
+    std::vector<glm::u8vec4> fieldData(size.x * size.y);
+    fieldData[i + size.x * (i % 3)].x = 128;
+    SetFieldData(*fields[i], fieldData);
+
+    advection.AdvectBind(*fields[i]);
+  }
+
+  advection.Advect();
+
+  device->Handle().waitIdle();
+
+  for (int i = 0; i < 6; i++)
+  {
+    auto pixels = GetFieldData(*fields[i]);
+
+    glm::ivec2 pos = glm::ivec2(i, i % 3) + glm::ivec2(vel);
+    ASSERT_EQ(128, pixels[pos.x + size.x * pos.y].x);
+  }
+}
+
 TEST(AdvectionTests, ParticleAdvect)
 {
   glm::ivec2 size(50);
@@ -77,6 +77,37 @@ TEST(ExtrapolateTest, Extrapolate)
   CheckValid(size, sim, valid);
 }
 
+TEST(ExtrapolateTest, ExtrapolateFront)
+{
+  glm::ivec2 size(50);
+
+  FluidSim sim;
+  sim.initialize(1.0f, size.x, size.y);
+  sim.set_boundary(complex_boundary_phi);
+
+  AddParticles(size, sim, complex_boundary_phi);
+
+  sim.add_force(0.01f);
+  sim.apply_projection(0.01f);
+
+  Buffer<glm::ivec2> valid(*device, size.x * size.y, VMA_MEMORY_USAGE_CPU_ONLY);
+  SetValid(size, sim, valid);
+
+  Velocity velocity(*device, size);
+  SetVelocity(*device, size, velocity, sim);
+
+  extrapolate(sim.u, sim.u_valid);
+  extrapolate(sim.v, sim.v_valid);
+
+  Extrapolation extrapolation(*device, size, valid, velocity, 10, Extrapolation::Method::Front);
+  extrapolation.Extrapolate();
+
+  device->Queue().waitIdle();
+
+  CheckVelocity(*device, size, velocity, sim);
+  CheckValid(size, sim, valid);
+}
+
 TEST(ExtrapolateTest, Constrain)
 {
   // FIXME increase size
@@ -113,6 +113,46 @@ TEST(LevelSetTests, ComplexCircles)
   CheckDifference(outTexture, complex_boundary_phi, 1.0f);
 }
 
+TEST(LevelSetTests, NarrowBand)
+{
+  glm::ivec2 size(50);
+  float bandWidth = 5.0f;
+
+  LevelSet levelSet(*device, size, 2000, bandWidth);
+  Texture outTexture(*device, size.x, size.y, vk::Format::eR32Sfloat, VMA_MEMORY_USAGE_CPU_ONLY);
+
+  Ellipse circle(*device, glm::vec2{rad0} * glm::vec2(size));
+  circle.Position = glm::vec2(c0[0], c0[1]) * glm::vec2(size) - glm::vec2(0.5f);
+  circle.Colour = glm::vec4(0.5f);
+
+  Clear clear(glm::vec4(-0.5f));
+
+  levelSet.Record({clear, circle}).Submit();
+  levelSet.Reinitialise();
+
+  device->Handle().waitIdle();
+
+  device->Execute(
+      [&](vk::CommandBuffer commandBuffer) { outTexture.CopyFrom(commandBuffer, levelSet); });
+
+  std::vector<float> pixels(size.x * size.y);
+  outTexture.CopyTo(pixels);
+
+  // only the values inside the band are a distance
+  for (int j = 0; j < size.y; j++)
+  {
+    for (int i = 0; i < size.x; i++)
+    {
+      Vec2f pos((i + 1.0f) / size.x, (j + 1.0f) / size.x);
+      float value = size.x * boundary_phi(pos);
+      if (std::abs(value) < bandWidth - 1.0f)
+      {
+        EXPECT_NEAR(value, pixels[i + j * size.x], 1.0f) << "Mismatch at " << i << ", " << j;
+      }
+    }
+  }
+}
+
 TEST(LevelSetTests, Extrapolate)
 {
   glm::ivec2 size(50);
@@ -151,3 +191,23 @@ TEST(LevelSetTests, Extrapolate)
     EXPECT_FLOAT_EQ(-0.5f, liquidData[20 + (i + 10) * size.x]);
   }
 }
+
+TEST(LevelSetTests, Version)
+{
+  glm::ivec2 size(50);
+
+  LevelSet levelSet(*device, size);
+  EXPECT_EQ(0, levelSet.GetVersion());
+
+  Clear clear(glm::vec4(-0.5f));
+  auto renderCommand = levelSet.Record({clear});
+  EXPECT_EQ(0, levelSet.GetVersion());
+
+  renderCommand.Submit();
+  EXPECT_EQ(1, levelSet.GetVersion());
+
+  levelSet.Reinitialise();
+  EXPECT_EQ(2, levelSet.GetVersion());
+
+  device->Handle().waitIdle();
+}
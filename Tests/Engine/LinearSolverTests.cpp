@@ -8,6 +8,7 @@
 #include <Vortex/Engine/LinearSolver/GaussSeidel.h>
 #include <Vortex/Engine/LinearSolver/IncompletePoisson.h>
 #include <Vortex/Engine/LinearSolver/Multigrid.h>
+#include <Vortex/Engine/LinearSolver/PipelinedConjugateGradient.h>
 #include <Vortex/Engine/LinearSolver/Reduce.h>
 #include <Vortex/Engine/LinearSolver/Transfer.h>
 #include <Vortex/Engine/Pressure.h>
@@ -106,6 +107,46 @@ TEST(LinearSolverTests, ReduceMax)
   ASSERT_EQ(150.0f, outputData[0]);
 }
 
+TEST(LinearSolverTests, ReduceInner)
+{
+  glm::ivec2 size(100, 150);
+  int total_size = size.x * size.y;
+
+  Buffer<float> a(*device, total_size, VMA_MEMORY_USAGE_CPU_ONLY);
+  Buffer<float> b(*device, total_size, VMA_MEMORY_USAGE_CPU_ONLY);
+  Buffer<float> c(*device, total_size, VMA_MEMORY_USAGE_CPU_ONLY);
+  Buffer<float> dot0(*device, 1, VMA_MEMORY_USAGE_CPU_ONLY);
+  Buffer<float> dot1(*device, 1, VMA_MEMORY_USAGE_CPU_ONLY);
+  Buffer<float> maximum(*device, 1, VMA_MEMORY_USAGE_CPU_ONLY);
+
+  ReduceInner reduce(*device, size);
+  auto reduceBound = reduce.Bind(a, b, c, dot0, dot1, maximum);
+
+  std::vector<float> aData(total_size, 2.0f);
+  std::vector<float> bData(total_size);
+  std::vector<float> cData(total_size, -1.0f);
+
+  {
+    int n = 0;
+    std::generate(bData.begin(), bData.end(), [&n] { return static_cast<float>(n++ % 7 - 4); });
+  }
+
+  CopyFrom(a, aData);
+  CopyFrom(b, bData);
+  CopyFrom(c, cData);
+
+  device->Execute([&](vk::CommandBuffer commandBuffer) { reduceBound.Record(commandBuffer); });
+
+  float dot0Data, dot1Data, maxData;
+  CopyTo(dot0, dot0Data);
+  CopyTo(dot1, dot1Data);
+  CopyTo(maximum, maxData);
+
+  ASSERT_EQ(std::inner_product(aData.begin(), aData.end(), bData.begin(), 0.0f), dot0Data);
+  ASSERT_EQ(std::inner_product(aData.begin(), aData.end(), cData.begin(), 0.0f), dot1Data);
+  ASSERT_EQ(4.0f, maxData);
+}
+
 TEST(LinearSolverTests, Transfer_Prolongate)
 {
   glm::ivec2 coarseSize(2);
@@ -177,6 +218,88 @@ TEST(LinearSolverTests, Transfer_Restrict)
   EXPECT_FLOAT_EQ((11.0f + 12.0f + 15.0f + 16.0f) / 4.0f, outputData[1 + coarseSize.x * 1]);
 }
 
+TEST(LinearSolverTests, Transfer_Restrict_Odd)
+{
+  glm::ivec2 coarseSize(2);
+  glm::ivec2 fineSize(3);
+
+  Transfer t(*device);
+
+  Buffer<float> fineDiagonal(*device, fineSize.x * fineSize.y, VMA_MEMORY_USAGE_CPU_ONLY);
+  std::vector<float> fineDiagonalData(fineSize.x * fineSize.y, {1.0f});
+  CopyFrom(fineDiagonal, fineDiagonalData);
+
+  Buffer<float> coarseDiagonal(*device, coarseSize.x * coarseSize.y, VMA_MEMORY_USAGE_CPU_ONLY);
+  std::vector<float> coarseDiagonalData(coarseSize.x * coarseSize.y, {1.0f});
+  CopyFrom(coarseDiagonal, coarseDiagonalData);
+
+  Buffer<float> input(*device, fineSize.x * fineSize.y, VMA_MEMORY_USAGE_CPU_ONLY);
+  Buffer<float> output(*device, coarseSize.x * coarseSize.y, VMA_MEMORY_USAGE_CPU_ONLY);
+
+  std::vector<float> data(fineSize.x * fineSize.y, 1.0f);
+  std::iota(data.begin(), data.end(), 1.0f);
+  CopyFrom(input, data);
+
+  t.RestrictBind(0, fineSize, input, fineDiagonal, output, coarseDiagonal);
+  device->Execute([&](vk::CommandBuffer commandBuffer) { t.Restrict(commandBuffer, 0); });
+
+  std::vector<float> outputData(coarseSize.x * coarseSize.y, 1.0f);
+  CopyTo(output, outputData);
+
+  EXPECT_FLOAT_EQ((1.0f + 2.0f + 4.0f + 5.0f) / 4.0f, outputData[0 + coarseSize.x * 0]);
+  EXPECT_FLOAT_EQ((3.0f + 6.0f) / 2.0f, outputData[1 + coarseSize.x * 0]);
+  EXPECT_FLOAT_EQ((7.0f + 8.0f) / 2.0f, outputData[0 + coarseSize.x * 1]);
+  EXPECT_FLOAT_EQ(9.0f, outputData[1 + coarseSize.x * 1]);
+}
+
+TEST(LinearSolverTests, Transfer_Prolongate_Odd)
+{
+  glm::ivec2 coarseSize(2);
+  glm::ivec2 fineSize(3);
+
+  Transfer t(*device);
+
+  Buffer<float> fineDiagonal(*device, fineSize.x * fineSize.y, VMA_MEMORY_USAGE_CPU_ONLY);
+  std::vector<float> fineDiagonalData(fineSize.x * fineSize.y, {1.0f});
+  CopyFrom(fineDiagonal, fineDiagonalData);
+
+  Buffer<float> coarseDiagonal(*device, coarseSize.x * coarseSize.y, VMA_MEMORY_USAGE_CPU_ONLY);
+  std::vector<float> coarseDiagonalData(coarseSize.x * coarseSize.y, {1.0f});
+  CopyFrom(coarseDiagonal, coarseDiagonalData);
+
+  Buffer<float> input(*device, coarseSize.x * coarseSize.y, VMA_MEMORY_USAGE_CPU_ONLY);
+  Buffer<float> output(*device, fineSize.x * fineSize.y, VMA_MEMORY_USAGE_CPU_ONLY);
+
+  std::vector<float> data(coarseSize.x * coarseSize.y, 0.0f);
+  std::iota(data.begin(), data.end(), 1.0f);
+  CopyFrom(input, data);
+
+  t.ProlongateBind(0, fineSize, output, fineDiagonal, input, coarseDiagonal);
+  device->Execute([&](vk::CommandBuffer commandBuffer) {
+    output.Clear(commandBuffer);
+    t.Prolongate(commandBuffer, 0);
+  });
+
+  std::vector<float> outputData(fineSize.x * fineSize.y, 0.0f);
+  CopyTo(output, outputData);
+
+  EXPECT_FLOAT_EQ(1.0f, outputData[1 + fineSize.x * 1]);
+  EXPECT_FLOAT_EQ(2.0f, outputData[2 + fineSize.x * 0]);
+  EXPECT_FLOAT_EQ(2.0f, outputData[2 + fineSize.x * 1]);
+  EXPECT_FLOAT_EQ(3.0f, outputData[1 + fineSize.x * 2]);
+  EXPECT_FLOAT_EQ(4.0f, outputData[2 + fineSize.x * 2]);
+}
+
+TEST(LinearSolverTests, Multigrid_Depth)
+{
+  Depth depth(glm::ivec2(50, 18));
+
+  ASSERT_EQ(2, depth.GetMaxDepth());
+  EXPECT_EQ(glm::ivec2(50, 18), depth.GetDepthSize(0));
+  EXPECT_EQ(glm::ivec2(25, 9), depth.GetDepthSize(1));
+  EXPECT_EQ(glm::ivec2(13, 5), depth.GetDepthSize(2));
+}
+
 TEST(LinearSolverTests, Error)
 {
   glm::ivec2 size(20);
@@ -332,6 +455,125 @@ TEST(LinearSolverTests, Diagonal_Simple_PCG)
   std::cout << "Solved with number of iterations: " << params.OutIterations << std::endl;
 }
 
+TEST(LinearSolverTests, Diagonal_Simple_PCG_CheckInterval)
+{
+  glm::ivec2 size(50);
+
+  FluidSim sim;
+  sim.initialize(1.0f, size.x, size.y);
+  sim.set_boundary(boundary_phi);
+
+  AddParticles(size, sim, boundary_phi);
+
+  sim.add_force(0.01f);
+  sim.compute_phi();
+  sim.extrapolate_phi();
+  sim.apply_projection(0.01f);
+
+  LinearSolver::Data data(*device, size, VMA_MEMORY_USAGE_CPU_ONLY);
+
+  BuildLinearEquation(size, data.Diagonal, data.Lower, data.B, sim);
+
+  Diagonal preconditioner(*device, size);
+  ConjugateGradient solver(*device, size, preconditioner);
+  solver.Bind(data.Diagonal, data.Lower, data.B, data.X);
+
+  LinearSolver::Parameters params(LinearSolver::Parameters::SolverType::Iterative, 1000, 1e-5f);
+  solver.Solve(params);
+
+  device->Queue().waitIdle();
+
+  LinearSolver::Parameters checkedParams(
+      LinearSolver::Parameters::SolverType::Iterative, 1000, 1e-5f, 8);
+  solver.Solve(checkedParams);
+
+  device->Queue().waitIdle();
+
+  CheckPressure(size, sim.pressure, data.X, 1e-5f);
+
+  // the per-iteration read is one iteration late
+  EXPECT_GT(checkedParams.OutIterations, 0u);
+  EXPECT_LE(checkedParams.OutIterations, params.OutIterations);
+
+  std::cout << "Solved with number of iterations: " << checkedParams.OutIterations << std::endl;
+}
+
+TEST(LinearSolverTests, Diagonal_Simple_PCG_WarmStart)
+{
+  glm::ivec2 size(50);
+
+  FluidSim sim;
+  sim.initialize(1.0f, size.x, size.y);
+  sim.set_boundary(boundary_phi);
+
+  AddParticles(size, sim, boundary_phi);
+
+  sim.add_force(0.01f);
+  sim.compute_phi();
+  sim.extrapolate_phi();
+  sim.apply_projection(0.01f);
+
+  LinearSolver::Data data(*device, size, VMA_MEMORY_USAGE_CPU_ONLY);
+
+  BuildLinearEquation(size, data.Diagonal, data.Lower, data.B, sim);
+
+  Diagonal preconditioner(*device, size);
+  ConjugateGradient solver(*device, size, preconditioner);
+  solver.Bind(data.Diagonal, data.Lower, data.B, data.X);
+
+  LinearSolver::Parameters params(LinearSolver::Parameters::SolverType::Iterative, 1000, 1e-5f);
+  solver.Solve(params);
+
+  device->Queue().waitIdle();
+
+  LinearSolver::Parameters warmParams(LinearSolver::Parameters::SolverType::Iterative, 1000, 1e-5f);
+  warmParams.WarmStart = true;
+  solver.Solve(warmParams);
+
+  device->Queue().waitIdle();
+
+  CheckPressure(size, sim.pressure, data.X, 1e-5f);
+
+  EXPECT_LT(warmParams.OutIterations, params.OutIterations);
+
+  std::cout << "Solved with number of iterations: " << warmParams.OutIterations << std::endl;
+}
+
+TEST(LinearSolverTests, Diagonal_Simple_PipelinedPCG)
+{
+  glm::ivec2 size(50);
+
+  FluidSim sim;
+  sim.initialize(1.0f, size.x, size.y);
+  sim.set_boundary(boundary_phi);
+
+  AddParticles(size, sim, boundary_phi);
+
+  sim.add_force(0.01f);
+  sim.compute_phi();
+  sim.extrapolate_phi();
+  sim.apply_projection(0.01f);
+
+  LinearSolver::Data data(*device, size, VMA_MEMORY_USAGE_CPU_ONLY);
+
+  BuildLinearEquation(size, data.Diagonal, data.Lower, data.B, sim);
+
+  Diagonal preconditioner(*device, size);
+
+  LinearSolver::Parameters params(LinearSolver::Parameters::SolverType::Iterative, 1000, 1e-5f);
+  PipelinedConjugateGradient solver(*device, size, preconditioner);
+
+  solver.Bind(data.Diagonal, data.Lower, data.B, data.X);
+  solver.Solve(params);
+
+  device->Queue().waitIdle();
+
+  // the recurrences of the pipelined variant accumulate more rounding errors
+  CheckPressure(size, sim.pressure, data.X, 1e-4f);
+
+  std::cout << "Solved with number of iterations: " << params.OutIterations << std::endl;
+}
+
 TEST(LinearSolverTests, GaussSeidel_Simple_PCG)
 {
   glm::ivec2 size(50);
@@ -479,6 +721,54 @@ TEST(LinearSolverTests, Multigrid_Simple_PCG)
   std::cout << "Solved with number of iterations: " << params.OutIterations << std::endl;
 }
 
+TEST(LinearSolverTests, Multigrid_NonPowerOfTwo_PCG)
+{
+  // non square, with an even width and an odd height
+  glm::ivec2 size(50, 37);
+
+  FluidSim sim;
+  sim.initialize(1.0f, size.x, size.y);
+  sim.set_boundary(boundary_phi);
+
+  AddParticles(size, sim, boundary_phi);
+
+  sim.add_force(0.01f);
+  sim.compute_phi();
+  sim.extrapolate_phi();
+  sim.apply_projection(0.01f);
+
+  LinearSolver::Data data(*device, size, VMA_MEMORY_USAGE_CPU_ONLY);
+
+  Velocity velocity(*device, size);
+  Texture liquidPhi(*device, size.x, size.y, vk::Format::eR32Sfloat);
+  Texture solidPhi(*device, size.x, size.y, vk::Format::eR32Sfloat);
+  Buffer<glm::ivec2> valid(*device, size.x * size.y, VMA_MEMORY_USAGE_CPU_ONLY);
+
+  SetSolidPhi(*device, size, solidPhi, sim, (float)size.x);
+  SetLiquidPhi(*device, size, liquidPhi, sim, (float)size.x);
+
+  BuildLinearEquation(size, data.Diagonal, data.Lower, data.B, sim);
+
+  Pressure pressure(*device, 0.01f, size, data, velocity, solidPhi, liquidPhi, valid);
+
+  Multigrid preconditioner(*device, size, 0.01f);
+  preconditioner.BuildHierarchiesBind(pressure, solidPhi, liquidPhi);
+
+  LinearSolver::Parameters params(LinearSolver::Parameters::SolverType::Iterative, 1000, 1e-5f);
+  ConjugateGradient solver(*device, size, preconditioner);
+
+  solver.Bind(data.Diagonal, data.Lower, data.B, data.X);
+
+  preconditioner.BuildHierarchies();
+  solver.Solve(params);
+
+  device->Queue().waitIdle();
+
+  CheckPressure(size, sim.pressure, data.X, 1e-5f);
+
+  std::cout << "Solved with number of iterations: " << params.OutIterations << std::endl;
+}
+
 TEST(LinearSolverTests, Multigrid_Simple)
 {
   glm::ivec2 size(64);
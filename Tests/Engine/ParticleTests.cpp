@@ -7,6 +7,7 @@
 #include "Verify.h"
 
 #include <glm/gtx/io.hpp>
+#include <limits>
 #include <numeric>
 #include <random>
 
@@ -436,6 +437,87 @@ TEST(ParticleTests, Phi)
   CheckPhi(size, sim, outTexture);
 }
 
+TEST(ParticleTests, JumpFloodPhi)
+{
+  glm::ivec2 size(50);
+
+  FluidSim sim;
+  sim.initialize(1.0f, size.x, size.y);
+  sim.set_boundary(boundary_phi);
+
+  AddParticles(size, sim, boundary_phi);
+
+  Buffer<Particle> particles(*device, 8 * size.x * size.y, VMA_MEMORY_USAGE_CPU_ONLY);
+
+  std::vector<Particle> particlesData;
+  std::vector<bool> empty(size.x * size.y, true);
+  for (auto& p : sim.particles)
+  {
+    Particle particle;
+    particle.Position = glm::vec2(p[0] * size.x, p[1] * size.x);
+    particlesData.push_back(particle);
+
+    glm::ivec2 cell(particle.Position);
+    empty[cell.x + cell.y * size.x] = false;
+  }
+  std::size_t count = particlesData.size();
+  particlesData.resize(8 * size.x * size.y);
+  CopyFrom(particles, particlesData);
+
+  ParticleCount particleCount(
+      *device, size, particles, Velocity::InterpolationMode::Cubic, {(int)count});
+
+  particleCount.Scan();
+  device->Handle().waitIdle();
+
+  LevelSet phi(*device, size);
+
+  particleCount.LevelSetBind(phi, ParticleCount::PhiMethod::JumpFlood);
+  particleCount.Phi();
+  device->Handle().waitIdle();
+
+  Texture outTexture(*device, size.x, size.y, vk::Format::eR32Sfloat, VMA_MEMORY_USAGE_CPU_ONLY);
+  device->Execute(
+      [&](vk::CommandBuffer commandBuffer) { outTexture.CopyFrom(commandBuffer, phi); });
+
+  std::vector<float> pixels(size.x * size.y);
+  outTexture.CopyTo(pixels);
+
+  // compare with the distances to all particles and empty cells
+  for (int i = 0; i < size.x; i++)
+  {
+    for (int j = 0; j < size.y; j++)
+    {
+      glm::vec2 centre(i + 0.5f, j + 0.5f);
+
+      float particleDistance = std::numeric_limits<float>::max();
+      for (std::size_t n = 0; n < count; n++)
+      {
+        particleDistance =
+            std::min(particleDistance, glm::distance(centre, particlesData[n].Position));
+      }
+
+      float emptyDistance = std::numeric_limits<float>::max();
+      for (int k = 0; k < size.x * size.y; k++)
+      {
+        if (empty[k])
+        {
+          glm::vec2 emptyCentre(k % size.x + 0.5f, k / size.x + 0.5f);
+          emptyDistance = std::min(emptyDistance, glm::distance(centre, emptyCentre));
+        }
+      }
+
+      float value = particleDistance - DefaultParticleSize();
+      if (value < 0.0f)
+      {
+        value = std::min(value, 0.5f - emptyDistance);
+      }
+
+      EXPECT_NEAR(value, pixels[i + j * size.x], 0.5f) << "Mismatch at " << i << "," << j;
+    }
+  }
+}
+
 TEST(ParticleTests, FromGrid_PIC)
 {
   // Small size otherwise test is too slow (due to O(n^2) search)
@@ -126,6 +126,35 @@ TEST(RigidbodyTests, Phi)
   CheckPhi(size, sim, outTexture);
 }
 
+TEST(RigidbodyTests, Moved)
+{
+  glm::ivec2 size(50);
+
+  RenderTexture solidPhi(*device, size.x, size.y, vk::Format::eR32Sfloat);
+
+  Vortex::Fluid::Rectangle rectangle(*device, glm::vec2(10.0f));
+  Vortex::Fluid::RigidBody rigidBody(
+      *device, size, rectangle, Vortex::Fluid::RigidBody::Type::eStatic);
+  rigidBody.BindPhi(solidPhi);
+
+  rigidBody.Position = glm::vec2(25.0f);
+  EXPECT_TRUE(rigidBody.IsMoved());
+
+  rigidBody.RenderPhi();
+  EXPECT_FALSE(rigidBody.IsMoved());
+
+  rigidBody.Rotation = 10.0f;
+  EXPECT_TRUE(rigidBody.IsMoved());
+
+  rigidBody.RenderPhi();
+  EXPECT_FALSE(rigidBody.IsMoved());
+
+  rigidBody.Position = glm::vec2(26.0f, 25.0f);
+  EXPECT_TRUE(rigidBody.IsMoved());
+
+  device->Handle().waitIdle();
+}
+
 TEST(RigidbodyTests, Div)
 {
   glm::ivec2 size(50);
@@ -202,6 +202,62 @@ TEST(WorldTests, Velocity)
   CheckVelocity(*device, size, world.GetVelocity(), velocityData);
 }
 
+TEST(WorldTests, BakedStep)
+{
+  float dt = 0.01f;
+  glm::vec2 size(64.0f, 64.0f);
+
+  Fluid::SmokeWorld world(*device, size, dt, Fluid::Velocity::InterpolationMode::Linear);
+  Fluid::SmokeWorld bakedWorld(*device, size, dt, Fluid::Velocity::InterpolationMode::Linear);
+
+  Renderer::Rectangle area(*device, size - glm::vec2(4.0f));
+  area.Position = glm::vec2(2.0f);
+  area.Colour = glm::vec4(-1.0f);
+
+  Renderer::Clear fluidClear({1.0f, 0.0f, 0.0f, 0.0f});
+  world.RecordLiquidPhi({fluidClear, area}).Submit().Wait();
+  bakedWorld.RecordLiquidPhi({fluidClear, area}).Submit().Wait();
+
+  Fluid::Circle obstacle(*device, 5.0f);
+  obstacle.Position = size / glm::vec2(2.0f);
+
+  world.RecordStaticSolidPhi({Fluid::BoundariesClear, obstacle}).Submit().Wait();
+  bakedWorld.RecordStaticSolidPhi({Fluid::BoundariesClear, obstacle}).Submit().Wait();
+
+  Renderer::Rectangle force(*device, glm::vec2(10.0f));
+  force.Position = {10.0f, 10.0f};
+  force.Colour = {10.0f, 5.0f, 0.0f, 0.0f};
+
+  auto velocity = world.RecordVelocity({force}, Fluid::VelocityOp::Add);
+  auto bakedVelocity = bakedWorld.RecordVelocity({force}, Fluid::VelocityOp::Add);
+
+  auto params = Fluid::FixedParams(20);
+  bakedWorld.BakeStep(params);
+
+  for (int i = 0; i < 3; i++)
+  {
+    world.SubmitVelocity(velocity);
+    world.Step(params);
+
+    bakedWorld.SubmitVelocity(bakedVelocity);
+    bakedWorld.Step(params);
+    EXPECT_EQ(20, params.OutIterations);
+  }
+
+  device->Handle().waitIdle();
+
+  Renderer::Texture output(
+      *device, size.x, size.y, vk::Format::eR32G32Sfloat, VMA_MEMORY_USAGE_CPU_ONLY);
+  device->Execute([&](vk::CommandBuffer commandBuffer) {
+    output.CopyFrom(commandBuffer, world.GetVelocity());
+  });
+
+  std::vector<glm::vec2> velocityData(size.x * size.y);
+  output.CopyTo(velocityData);
+
+  CheckVelocity(*device, size, bakedWorld.GetVelocity(), velocityData, 1e-5f);
+}
+
 TEST(CflTets, Max)
 {
   glm::ivec2 size(50);
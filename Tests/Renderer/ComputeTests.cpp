@@ -4,11 +4,18 @@
 //
 
 #include <gtest/gtest.h>
+#include <cstdio>
 #include <fstream>
+#include <iterator>
 
 #include <Vortex/Renderer/CommandBuffer.h>
 #include <Vortex/Renderer/DescriptorSet.h>
+#include <Vortex/Renderer/Instance.h>
+#include <Vortex/Renderer/LocalSizeTuner.h>
+#include <Vortex/Renderer/PassGraph.h>
 #include <Vortex/Renderer/Pipeline.h>
+#include <Vortex/Renderer/PipelineBarrier.h>
+#include <Vortex/Renderer/Profiler.h>
 #include <Vortex/Renderer/Timer.h>
 #include <Vortex/Renderer/Work.h>
 #include <Vortex/SPIRV/Reflection.h>
@@ -189,6 +196,96 @@ TEST(ComputeTests, Work)
   CheckBuffer(expectedOutput, buffer);
 }
 
+TEST(ComputeTests, PipelineBarrier)
+{
+  Buffer<float> buffer1(*device, 16 * 16, VMA_MEMORY_USAGE_CPU_ONLY);
+  Buffer<float> buffer2(*device, 16 * 16, VMA_MEMORY_USAGE_CPU_ONLY);
+  Work work1(*device, glm::ivec2(16), Work_comp, SpecConst(SpecConstValue(3, 1)));
+  Work work2(*device, glm::ivec2(16), Work_comp, SpecConst(SpecConstValue(3, 2)));
+
+  auto boundWork1 = work1.Bind({buffer1});
+  auto boundWork2 = work2.Bind({buffer2});
+
+  device->Execute([&](vk::CommandBuffer commandBuffer) {
+    boundWork1.Record(commandBuffer);
+    boundWork2.Record(commandBuffer);
+    ComputeBarrier(commandBuffer, {buffer1, buffer2});
+
+    PipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eHost)
+        .Add(buffer1, vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eHostRead)
+        .Add(buffer2, vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eHostRead)
+        .Record(commandBuffer);
+  });
+
+  std::vector<float> expectedOutput1(16 * 16), expectedOutput2(16 * 16);
+  for (int i = 0; i < 16; i++)
+  {
+    for (int j = 0; j < 16; j++)
+    {
+      bool even = (i + j) % 2 == 0;
+      expectedOutput1[i + j * 16] = even ? 1.0f : 0.0f;
+      expectedOutput2[i + j * 16] = even ? 2.0f : 0.0f;
+    }
+  }
+
+  CheckBuffer(expectedOutput1, buffer1);
+  CheckBuffer(expectedOutput2, buffer2);
+}
+
+TEST(ComputeTests, PassGraph)
+{
+  Buffer<float> buffer1(*device, 16 * 16, VMA_MEMORY_USAGE_CPU_ONLY);
+  Buffer<float> buffer2(*device, 16 * 16, VMA_MEMORY_USAGE_CPU_ONLY);
+  Buffer<float> buffer3(*device, 16 * 16, VMA_MEMORY_USAGE_CPU_ONLY);
+  Work work(*device, glm::ivec2(16), Work_comp, SpecConst(SpecConstValue(3, 1)));
+
+  auto boundWork1 = work.Bind({buffer1});
+  auto boundWork2 = work.Bind({buffer2});
+
+  PassGraph graph;
+  graph.AddPass("Write 1", {}, {buffer1}, [&](vk::CommandBuffer commandBuffer) {
+    boundWork1.Record(commandBuffer);
+  });
+  graph.AddPass("Write 2", {}, {buffer2}, [&](vk::CommandBuffer commandBuffer) {
+    boundWork2.Record(commandBuffer);
+  });
+  graph.AddPass("Read 1 and 2", {buffer1, buffer2}, {buffer3}, [](vk::CommandBuffer) {});
+  graph.AddPass("Write 1 again", {}, {buffer1}, [](vk::CommandBuffer) {});
+
+  auto& schedule = graph.GetSchedule();
+  ASSERT_EQ(4, schedule.size());
+
+  EXPECT_EQ(std::vector<std::size_t>({0, 1}), schedule[0].Passes);
+  EXPECT_TRUE(schedule[0].Barriers.empty());
+
+  EXPECT_EQ(std::vector<std::size_t>({2}), schedule[1].Passes);
+  EXPECT_EQ(2, schedule[1].Barriers.size());
+
+  // write after read, only an execution dependency
+  EXPECT_EQ(std::vector<std::size_t>({3}), schedule[2].Passes);
+  EXPECT_TRUE(schedule[2].Barriers.empty());
+
+  EXPECT_TRUE(schedule[3].Passes.empty());
+  EXPECT_EQ(2, schedule[3].Barriers.size());
+
+  EXPECT_EQ(4, graph.GetBarrierCount());
+  EXPECT_EQ("Read 1 and 2", graph.GetName(2));
+
+  device->Execute([&](vk::CommandBuffer commandBuffer) { graph.Record(commandBuffer); });
+
+  std::vector<float> expectedOutput(16 * 16);
+  for (int i = 0; i < 16; i++)
+  {
+    for (int j = 0; j < 16; j++)
+    {
+      expectedOutput[i + j * 16] = (i + j) % 2 == 0 ? 1.0f : 0.0f;
+    }
+  }
+
+  CheckBuffer(expectedOutput, buffer1);
+  CheckBuffer(expectedOutput, buffer2);
+}
+
 TEST(ComputeTests, WorkIndirect)
 {
   glm::ivec2 size(16, 1);
@@ -368,6 +465,94 @@ TEST(ComputeTests, Checkerboard)
   CheckBuffer(expectedOutput, buffer);
 }
 
+TEST(ComputeTests, WithLocalSize)
+{
+  glm::ivec2 size(50);
+
+  auto gridSize = ComputeSize(size).WithLocalSize({16, 16});
+  EXPECT_EQ(glm::ivec2(4, 4), gridSize.WorkSize);
+  EXPECT_EQ(glm::ivec2(16, 16), gridSize.LocalSize);
+
+  auto stencilSize = MakeStencilComputeSize(size, 1).WithLocalSize({16, 16});
+  EXPECT_EQ(glm::ivec2(4, 4), stencilSize.WorkSize);
+
+  auto checkerboardSize = MakeCheckerboardComputeSize(size).WithLocalSize({16, 16});
+  EXPECT_EQ(glm::ivec2(2, 4), checkerboardSize.WorkSize);
+
+  auto fixedSize = ComputeSize(size, {8, 8}).WithLocalSize({16, 16});
+  EXPECT_EQ(glm::ivec2(8, 8), fixedSize.LocalSize);
+  EXPECT_EQ(glm::ivec2(7, 7), fixedSize.WorkSize);
+}
+
+TEST(ComputeTests, LocalSizeTuner)
+{
+  auto properties = device->GetPhysicalDevice().getProperties();
+  if (!properties.limits.timestampComputeAndGraphics)
+  {
+    return;
+  }
+
+  const std::string path = "vortex_tests_local_sizes.txt";
+  std::remove(path.c_str());
+
+  glm::ivec2 size(50);
+  auto computeSize = MakeStencilComputeSize(size, 1);
+
+  SpirvBinary spirv(Stencil_comp);
+  auto shader = HashSpirv(spirv.data(), spirv.words());
+
+  glm::ivec2 localSize;
+  {
+    Instance instance("Tests", {}, false);
+    Device tuneDevice(instance, false);
+    tuneDevice.GetLocalSizeTuner().Load(path);
+    tuneDevice.GetLocalSizeTuner().SetTuning(true);
+
+    Buffer<float> input(tuneDevice, size.x * size.y);
+    Buffer<float> output(tuneDevice, size.x * size.y);
+
+    // tuned when first bound
+    Work work(tuneDevice, computeSize, Stencil_comp);
+    work.Bind({input, output});
+
+    ASSERT_TRUE(tuneDevice.GetLocalSizeTuner().Find(shader, computeSize, localSize));
+  }
+
+  // saved when the device is destroyed, and used by the works
+  Instance instance("Tests", {}, false);
+  Device loadDevice(instance, false);
+  loadDevice.GetLocalSizeTuner().Load(path);
+
+  glm::ivec2 loadedLocalSize;
+  ASSERT_TRUE(loadDevice.GetLocalSizeTuner().Find(shader, computeSize, loadedLocalSize));
+  EXPECT_EQ(localSize, loadedLocalSize);
+
+  Buffer<float> input(loadDevice, size.x * size.y, VMA_MEMORY_USAGE_CPU_ONLY);
+  Buffer<float> output(loadDevice, size.x * size.y, VMA_MEMORY_USAGE_CPU_ONLY);
+
+  Work work(loadDevice, computeSize, Stencil_comp);
+  auto boundWork = work.Bind({input, output});
+
+  std::vector<float> inputData(size.x * size.y, 1.0f);
+  CopyFrom(input, inputData);
+
+  loadDevice.Execute([&](vk::CommandBuffer commandBuffer) { boundWork.Record(commandBuffer); });
+
+  std::vector<float> bufferOutput(size.x * size.y);
+  CopyTo(output, bufferOutput);
+
+  for (int i = 1; i < size.x - 1; i++)
+  {
+    for (int j = 1; j < size.y - 1; j++)
+    {
+      int index = i + j * size.x;
+      EXPECT_EQ(5.0f, bufferOutput[index]) << "Value not equal at " << index;
+    }
+  }
+
+  std::remove(path.c_str());
+}
+
 TEST(ComputeTests, Timer)
 {
   auto properties = device->GetPhysicalDevice().getProperties();
@@ -403,6 +588,97 @@ TEST(ComputeTests, Timer)
   std::cout << "Elapsed time: " << time << std::endl;
 }
 
+TEST(ComputeTests, Profiler)
+{
+  auto properties = device->GetPhysicalDevice().getProperties();
+  if (!properties.limits.timestampComputeAndGraphics)
+  {
+    return;
+  }
+
+  glm::ivec2 size(500);
+
+  Buffer<float> buffer(*device, size.x * size.y);
+  Work work(*device, size, Work_comp);
+
+  auto boundWork = work.Bind({buffer});
+
+  Profiler profiler(*device);
+
+  CommandBuffer cmd(*device);
+  cmd.Record([&](vk::CommandBuffer commandBuffer) {
+    commandBuffer.debugMarkerBeginEXT({"Outer", {{1.0f, 1.0f, 1.0f, 1.0f}}}, device->Loader());
+    for (int i = 0; i < 2; i++)
+    {
+      commandBuffer.debugMarkerBeginEXT({"Inner", {{1.0f, 1.0f, 1.0f, 1.0f}}}, device->Loader());
+      boundWork.Record(commandBuffer);
+      commandBuffer.debugMarkerEndEXT(device->Loader());
+    }
+    commandBuffer.debugMarkerEndEXT(device->Loader());
+  });
+
+  cmd.Submit().Wait();
+
+  auto stages = profiler.Resolve();
+  ASSERT_EQ(2, stages.size());
+
+  EXPECT_EQ("Outer", stages[0].Name);
+  EXPECT_EQ(0, stages[0].Depth);
+  EXPECT_EQ(1, stages[0].Count);
+
+  EXPECT_EQ("Outer/Inner", stages[1].Name);
+  EXPECT_EQ(1, stages[1].Depth);
+  EXPECT_EQ(2, stages[1].Count);
+
+  EXPECT_GT(stages[0].LastExecutionNs, 0);
+  EXPECT_GE(stages[0].LastExecutionNs, stages[1].LastExecutionNs);
+}
+
+TEST(ComputeTests, ProfilerTrace)
+{
+  auto properties = device->GetPhysicalDevice().getProperties();
+  if (!properties.limits.timestampComputeAndGraphics)
+  {
+    return;
+  }
+
+  const std::string path = "vortex_tests_trace.json";
+
+  glm::ivec2 size(500);
+
+  Buffer<float> buffer(*device, size.x * size.y);
+  Work work(*device, size, Work_comp);
+
+  auto boundWork = work.Bind({buffer});
+
+  Profiler profiler(*device);
+
+  CommandBuffer cmd(*device);
+  cmd.Record([&](vk::CommandBuffer commandBuffer) {
+    commandBuffer.debugMarkerBeginEXT({"Traced", {{1.0f, 1.0f, 1.0f, 1.0f}}}, device->Loader());
+    boundWork.Record(commandBuffer);
+    commandBuffer.debugMarkerEndEXT(device->Loader());
+  });
+
+  profiler.BeginTrace();
+  cmd.Submit().Wait();
+  device->Execute([&](vk::CommandBuffer commandBuffer) { boundWork.Record(commandBuffer); });
+  profiler.EndTrace(path);
+
+  std::ifstream file(path);
+  ASSERT_TRUE(file.is_open());
+  std::string trace((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+  file.close();
+
+  EXPECT_NE(std::string::npos, trace.find("\"traceEvents\""));
+  EXPECT_NE(std::string::npos, trace.find("\"name\":\"Submit\""));
+  EXPECT_NE(std::string::npos, trace.find("\"name\":\"Wait\""));
+  EXPECT_NE(std::string::npos, trace.find("\"name\":\"Execute\""));
+  EXPECT_NE(std::string::npos, trace.find("\"name\":\"Traced\",\"cat\":\"gpu\""));
+
+  std::remove(path.c_str());
+}
+
 TEST(ComputeTests, Reflection)
 {
   Reflection spirv1(Stencil_comp);
@@ -456,3 +732,139 @@ TEST(ComputeTests, Cache)
   EXPECT_EQ(pipelineLayout2, device->GetLayoutManager().GetPipelineLayout(layout2));
   EXPECT_EQ(pipeline2, device->GetPipelineCache().CreateComputePipeline(shader2, pipelineLayout2));
 }
+
+TEST(ComputeTests, DescriptorPool)
+{
+  Reflection reflection(Stencil_comp);
+  PipelineLayout layout = {{reflection}};
+
+  auto& layoutManager = device->GetLayoutManager();
+  auto statistics = layoutManager.GetStatistics();
+
+  // freed sets are re-used
+  {
+    auto descriptorSet = layoutManager.MakeDescriptorSet(layout);
+  }
+
+  auto allocatedSets = layoutManager.GetStatistics().NumAllocatedSets;
+  EXPECT_LE(allocatedSets, statistics.NumAllocatedSets + 1);
+  EXPECT_GE(layoutManager.GetStatistics().NumFreeSets, 1u);
+
+  {
+    auto descriptorSet = layoutManager.MakeDescriptorSet(layout);
+    EXPECT_EQ(allocatedSets, layoutManager.GetStatistics().NumAllocatedSets);
+  }
+
+  // new pools are created when needed
+  std::vector<DescriptorSet> descriptorSets;
+  for (int i = 0; i < 1024; i++)
+  {
+    descriptorSets.push_back(layoutManager.MakeDescriptorSet(layout));
+  }
+
+  EXPECT_GT(layoutManager.GetStatistics().NumPools, statistics.NumPools);
+  EXPECT_GE(layoutManager.GetStatistics().NumAllocatedSets, 1024u);
+
+  descriptorSets.clear();
+  EXPECT_GE(layoutManager.GetStatistics().NumFreeSets, 1024u);
+}
+
+TEST(ComputeTests, Hash)
+{
+  Reflection reflection1(Buffer_comp);
+  Reflection reflection2(Image_comp);
+
+  PipelineLayout layout1 = {{reflection1}};
+  PipelineLayout layout2 = {{reflection1}};
+  PipelineLayout layout3 = {{reflection2}};
+
+  EXPECT_EQ(layout1, layout2);
+  EXPECT_EQ(std::hash<PipelineLayout>()(layout1), std::hash<PipelineLayout>()(layout2));
+  EXPECT_NE(std::hash<PipelineLayout>()(layout1), std::hash<PipelineLayout>()(layout3));
+
+  auto specConst1 = SpecConst(SpecConstValue(1, 16), SpecConstValue(2, 4));
+  auto specConst2 = SpecConst(SpecConstValue(1, 16), SpecConstValue(2, 4));
+  auto specConst3 = SpecConst(SpecConstValue(1, 4), SpecConstValue(2, 16));
+
+  EXPECT_EQ(std::hash<SpecConstInfo>()(specConst1), std::hash<SpecConstInfo>()(specConst2));
+  EXPECT_NE(std::hash<SpecConstInfo>()(specConst1), std::hash<SpecConstInfo>()(specConst3));
+}
+
+TEST(ComputeTests, CacheAsync)
+{
+  auto shader = device->GetShaderModule(Buffer_comp);
+  Reflection reflection(Buffer_comp);
+
+  PipelineLayout layout = {{reflection}};
+  vk::PipelineLayout pipelineLayout = device->GetLayoutManager().GetPipelineLayout(layout);
+
+  std::vector<std::shared_future<vk::Pipeline>> pipelines;
+  for (int i = 0; i < 8; i++)
+  {
+    pipelines.push_back(device->GetPipelineCache().CreateComputePipelineAsync(
+        shader, pipelineLayout, SpecConst(SpecConstValue(1, 16 * (i + 1)))));
+  }
+
+  device->GetPipelineCache().Wait();
+
+  for (int i = 0; i < 8; i++)
+  {
+    EXPECT_NE(vk::Pipeline(), pipelines[i].get());
+    EXPECT_EQ(pipelines[i].get(),
+              device->GetPipelineCache().CreateComputePipeline(
+                  shader, pipelineLayout, SpecConst(SpecConstValue(1, 16 * (i + 1)))));
+  }
+}
+
+TEST(ComputeTests, CacheFile)
+{
+  const std::string path = "vortex_tests_pipeline_cache.bin";
+
+  {
+    Instance instance("Tests", {}, false);
+    Device cacheDevice(instance, false, path);
+
+    auto shader = cacheDevice.GetShaderModule(Buffer_comp);
+    Reflection reflection(Buffer_comp);
+
+    PipelineLayout layout = {{reflection}};
+    vk::PipelineLayout pipelineLayout = cacheDevice.GetLayoutManager().GetPipelineLayout(layout);
+    EXPECT_NE(vk::Pipeline(),
+              cacheDevice.GetPipelineCache().CreateComputePipeline(shader, pipelineLayout));
+  }
+
+  // saved when the device is destroyed
+  std::ifstream savedFile(path, std::ios::binary | std::ios::ate);
+  ASSERT_TRUE(savedFile.is_open());
+  EXPECT_GT(savedFile.tellg(), 0);
+  savedFile.close();
+
+  // the saved file is loaded back
+  {
+    Instance instance("Tests", {}, false);
+    Device cacheDevice(instance, false, path);
+    EXPECT_TRUE(cacheDevice.GetPipelineCache().IsLoaded());
+  }
+
+  // an invalid file is ignored
+  {
+    std::ofstream invalidFile(path, std::ios::binary | std::ios::trunc);
+    invalidFile << "invalid pipeline cache";
+  }
+
+  {
+    Instance instance("Tests", {}, false);
+    Device cacheDevice(instance, false, path);
+
+    auto shader = cacheDevice.GetShaderModule(Buffer_comp);
+    Reflection reflection(Buffer_comp);
+
+    PipelineLayout layout = {{reflection}};
+    vk::PipelineLayout pipelineLayout = cacheDevice.GetLayoutManager().GetPipelineLayout(layout);
+    EXPECT_FALSE(cacheDevice.GetPipelineCache().IsLoaded());
+    EXPECT_NE(vk::Pipeline(),
+              cacheDevice.GetPipelineCache().CreateComputePipeline(shader, pipelineLayout));
+  }
+
+  std::remove(path.c_str());
+}
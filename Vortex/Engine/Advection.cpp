@@ -10,41 +10,86 @@
 
 #include "vortex_generated_spirv.h"
 
+#include <algorithm>
+
 namespace Vortex
 {
 namespace Fluid
 {
+namespace
+{
+// number of fields bindings in Advect.comp
+const std::size_t MaxFields = 4;
+
+bool IsSamplerMode(Velocity::InterpolationMode interpolationMode)
+{
+  return interpolationMode == Velocity::InterpolationMode::LinearSampler ||
+         interpolationMode == Velocity::InterpolationMode::CubicSampler;
+}
+
+// the fields are traced with the linear interpolation of the velocity,
+// unless one of the sampler modes is used
+Velocity::InterpolationMode FieldInterpolationMode(Velocity::InterpolationMode interpolationMode)
+{
+  return IsSamplerMode(interpolationMode) ? interpolationMode : Velocity::InterpolationMode::Linear;
+}
+
+void CheckLinearFilter(const Renderer::Device& device, vk::Format format)
+{
+  auto properties = device.GetPhysicalDevice().getFormatProperties(format);
+  if (!(properties.optimalTilingFeatures & vk::FormatFeatureFlagBits::eSampledImageFilterLinear))
+  {
+    throw std::runtime_error("Sampler interpolation modes not supported by the device");
+  }
+}
+}  // namespace
+
 Advection::Advection(const Renderer::Device& device,
                      const glm::ivec2& size,
                      float dt,
                      Velocity& velocity,
-                     Velocity::InterpolationMode interpolationMode)
+                     Velocity::InterpolationMode interpolationMode,
+                     Integrator integrator)
     : mDevice(device)
     , mDt(dt)
     , mSize(size)
     , mVelocity(velocity)
+    , mParticles(nullptr)
+    , mDispatchParams(nullptr)
+    , mSampler(Renderer::SamplerBuilder()
+                   .AddressMode(vk::SamplerAddressMode::eClampToEdge)
+                   .Filter(vk::Filter::eLinear)
+                   .Create(device.Handle()))
+    , mInterpolationMode(interpolationMode)
     , mVelocityAdvect(device,
                       size,
                       SPIRV::AdvectVelocity_comp,
-                      Renderer::SpecConst(Renderer::SpecConstValue(3, interpolationMode)))
-    , mVelocityAdvectBound(mVelocityAdvect.Bind({velocity, velocity.Output()}))
-    , mAdvect(device, size, SPIRV::Advect_comp)
+                      Renderer::SpecConst(Renderer::SpecConstValue(3, interpolationMode),
+                                          Renderer::SpecConstValue(4, integrator)))
+    , mVelocityAdvectBound(
+          mVelocityAdvect.Bind({velocity, velocity.Output(), {*mSampler, velocity}}))
+    , mAdvect(device,
+              size,
+              SPIRV::Advect_comp,
+              Renderer::SpecConst(
+                  Renderer::SpecConstValue(3, FieldInterpolationMode(interpolationMode)),
+                  Renderer::SpecConstValue(4, integrator)))
     , mAdvectParticles(device,
                        Renderer::ComputeSize::Default1D(),
                        SPIRV::AdvectParticles_comp,
-                       Renderer::SpecConst(Renderer::SpecConstValue(3, interpolationMode)))
+                       Renderer::SpecConst(Renderer::SpecConstValue(3, interpolationMode),
+                                          Renderer::SpecConstValue(4, integrator)))
     , mAdvectVelocityCmd(device, false)
-    , mAdvectCmd(device, false)
+    , mAdvectCmd(device)
     , mAdvectParticlesCmd(device, false)
 {
-  mAdvectVelocityCmd.Record([&](vk::CommandBuffer commandBuffer) {
-    commandBuffer.debugMarkerBeginEXT({"Velocity advect", {{0.15f, 0.46f, 0.19f, 1.0f}}},
-                                      mDevice.Loader());
-    mVelocityAdvectBound.PushConstant(commandBuffer, dt);
-    mVelocityAdvectBound.Record(commandBuffer);
-    velocity.CopyBack(commandBuffer);
-    commandBuffer.debugMarkerEndEXT(mDevice.Loader());
-  });
+  if (IsSamplerMode(interpolationMode))
+  {
+    CheckLinearFilter(device, velocity.GetFormat());
+  }
+
+  mAdvectVelocityCmd.Record(
+      [&](vk::CommandBuffer commandBuffer) { AdvectVelocity(commandBuffer); });
 }
 
 void Advection::AdvectVelocity()
@@ -54,27 +99,71 @@ void Advection::AdvectVelocity()
 
 void Advection::AdvectBind(Density& density)
 {
-  mAdvectBound = mAdvect.Bind({mVelocity, density, density.mFieldBack});
-  mAdvectCmd.Record([&](vk::CommandBuffer commandBuffer) {
-    commandBuffer.debugMarkerBeginEXT({"Density advect", {{0.86f, 0.14f, 0.52f, 1.0f}}},
-                                      mDevice.Loader());
-    mAdvectBound.PushConstant(commandBuffer, mDt);
-    mAdvectBound.Record(commandBuffer);
-    density.mFieldBack.Barrier(commandBuffer,
-                               vk::ImageLayout::eGeneral,
-                               vk::AccessFlagBits::eShaderWrite,
-                               vk::ImageLayout::eGeneral,
-                               vk::AccessFlagBits::eShaderRead);
-    density.CopyFrom(commandBuffer, density.mFieldBack);
-    commandBuffer.debugMarkerEndEXT(mDevice.Loader());
-  });
+  if (std::find(mDensities.begin(), mDensities.end(), &density) == mDensities.end())
+  {
+    if (IsSamplerMode(mInterpolationMode))
+    {
+      CheckLinearFilter(mDevice, density.GetFormat());
+    }
+
+    mDensities.push_back(&density);
+    BindDensities();
+  }
+}
+
+void Advection::AdvectUnbind(Density& density)
+{
+  auto it = std::find(mDensities.begin(), mDensities.end(), &density);
+  if (it != mDensities.end())
+  {
+    mDensities.erase(it);
+    BindDensities();
+  }
+}
+
+void Advection::BindDensities()
+{
+  // the descriptor sets freed below can be re-used straight away, they must
+  // not be in use by a previous advection.
+  mAdvectCmd.Wait();
+
+  // the fields are bound in groups, the unused bindings of the last group
+  // are set to its first field, but are not advected.
+  mAdvectBounds.clear();
+  for (std::size_t i = 0; i < mDensities.size(); i += MaxFields)
+  {
+    std::vector<Density*> fields;
+    for (std::size_t j = i; j < i + MaxFields; j++)
+    {
+      fields.push_back(mDensities[j < mDensities.size() ? j : i]);
+    }
+
+    std::vector<Renderer::BindingInput> inputs = {mVelocity};
+    for (auto field : fields)
+    {
+      inputs.push_back(*field);
+    }
+    for (auto field : fields)
+    {
+      inputs.push_back(field->mFieldBack);
+    }
+    inputs.push_back({*mSampler, mVelocity});
+    for (auto field : fields)
+    {
+      inputs.push_back({*mSampler, *field});
+    }
+
+    mAdvectBounds.push_back(mAdvect.Bind(inputs));
+  }
+
+  mAdvectCmd.Record([&](vk::CommandBuffer commandBuffer) { Advect(commandBuffer); });
 }
 
 void Advection::Advect()
 {
   if (mAdvectCmd)
   {
-    mAdvectCmd.Submit();
+    mAdvectCmd.Wait().Submit();
   }
 }
 
@@ -83,17 +172,12 @@ void Advection::AdvectParticleBind(
     Renderer::Texture& levelSet,
     Renderer::IndirectBuffer<Renderer::DispatchParams>& dispatchParams)
 {
+  mParticles = &particles;
+  mDispatchParams = &dispatchParams;
   mAdvectParticlesBound =
       mAdvectParticles.Bind(mSize, {particles, dispatchParams, mVelocity, levelSet});
-  mAdvectParticlesCmd.Record([&](vk::CommandBuffer commandBuffer) {
-    commandBuffer.debugMarkerBeginEXT({"Particle advect", {{0.09f, 0.17f, 0.36f, 1.0f}}},
-                                      mDevice.Loader());
-    mAdvectParticlesBound.PushConstant(commandBuffer, mDt);
-    mAdvectParticlesBound.RecordIndirect(commandBuffer, dispatchParams);
-    particles.Barrier(
-        commandBuffer, vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead);
-    commandBuffer.debugMarkerEndEXT(mDevice.Loader());
-  });
+  mAdvectParticlesCmd.Record(
+      [&](vk::CommandBuffer commandBuffer) { AdvectParticles(commandBuffer); });
 }
 
 void Advection::AdvectParticles()
@@ -101,5 +185,56 @@ void Advection::AdvectParticles()
   mAdvectParticlesCmd.Submit();
 }
 
+void Advection::AdvectVelocity(vk::CommandBuffer commandBuffer)
+{
+  commandBuffer.debugMarkerBeginEXT({"Velocity advect", {{0.15f, 0.46f, 0.19f, 1.0f}}},
+                                    mDevice.Loader());
+  mVelocityAdvectBound.PushConstant(commandBuffer, mDt);
+  mVelocityAdvectBound.Record(commandBuffer);
+  mVelocity.CopyBack(commandBuffer);
+  commandBuffer.debugMarkerEndEXT(mDevice.Loader());
+}
+
+void Advection::Advect(vk::CommandBuffer commandBuffer)
+{
+  if (mDensities.empty())
+  {
+    return;
+  }
+
+  commandBuffer.debugMarkerBeginEXT({"Density advect", {{0.86f, 0.14f, 0.52f, 1.0f}}},
+                                    mDevice.Loader());
+  for (std::size_t i = 0; i < mAdvectBounds.size(); i++)
+  {
+    int count = static_cast<int>(std::min(MaxFields, mDensities.size() - i * MaxFields));
+    mAdvectBounds[i].PushConstant(commandBuffer, mDt, count);
+    mAdvectBounds[i].Record(commandBuffer);
+  }
+
+  for (auto density : mDensities)
+  {
+    density->mFieldBack.Barrier(commandBuffer,
+                                vk::ImageLayout::eGeneral,
+                                vk::AccessFlagBits::eShaderWrite,
+                                vk::ImageLayout::eGeneral,
+                                vk::AccessFlagBits::eShaderRead);
+    density->CopyFrom(commandBuffer, density->mFieldBack);
+  }
+  commandBuffer.debugMarkerEndEXT(mDevice.Loader());
+}
+
+void Advection::AdvectParticles(vk::CommandBuffer commandBuffer)
+{
+  assert(mParticles != nullptr && mDispatchParams != nullptr);
+
+  commandBuffer.debugMarkerBeginEXT({"Particle advect", {{0.09f, 0.17f, 0.36f, 1.0f}}},
+                                    mDevice.Loader());
+  mAdvectParticlesBound.PushConstant(commandBuffer, mDt);
+  mAdvectParticlesBound.RecordIndirect(commandBuffer, *mDispatchParams);
+  mParticles->Barrier(
+      commandBuffer, vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead);
+  commandBuffer.debugMarkerEndEXT(mDevice.Loader());
+}
+
 }  // namespace Fluid
 }  // namespace Vortex
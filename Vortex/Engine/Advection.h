@@ -11,6 +11,8 @@
 
 #include <Vortex/Engine/Velocity.h>
 
+#include <vector>
+
 namespace Vortex
 {
 namespace Fluid
@@ -23,36 +25,72 @@ class Density;
 class Advection
 {
 public:
+  /**
+   * @brief Integrator used to trace back the positions. Each order samples
+   * the velocity once more.
+   */
+  enum class Integrator : int
+  {
+    Euler = 0,
+    RK2 = 1,
+    RK3 = 2,
+  };
+
   /**
    * @brief Initialize advection kernels and related object.
    * @param device vulkan device
    * @param size size of velocity field
    * @param dt delta time for integration
    * @param velocity velocity field
+   * @param interpolationMode velocity interpolation
+   * @param integrator integrator to trace back the positions
    */
   VORTEX_API Advection(const Renderer::Device& device,
                        const glm::ivec2& size,
                        float dt,
                        Velocity& velocity,
-                       Velocity::InterpolationMode interpolationMode);
+                       Velocity::InterpolationMode interpolationMode,
+                       Integrator integrator = Integrator::RK3);
 
   /**
    * @brief Self advect velocity
    */
   VORTEX_API void AdvectVelocity();
 
-  // TODO can only advect one field, need to be able to do as many as we want
   /**
-   * @brief Binds a density field to be advected.
+   * @brief Record the velocity self advection in a command buffer.
+   * @param commandBuffer command buffer to record into
+   */
+  VORTEX_API void AdvectVelocity(vk::CommandBuffer commandBuffer);
+
+  /**
+   * @brief Binds a density field to be advected, in addition to the ones
+   * already bound. The fields are advected together, tracing the velocity
+   * once per cell for up to four fields. A field already bound is ignored.
    * @param density density field
    */
   VORTEX_API void AdvectBind(Density& density);
 
   /**
-   * @brief Performs an advection of the density field. Asynchronous operation.
+   * @brief Unbinds a density field, which must be done before it is
+   * destroyed.
+   * @param density density field
+   */
+  VORTEX_API void AdvectUnbind(Density& density);
+
+  /**
+   * @brief Performs an advection of the density fields. Asynchronous
+   * operation.
    */
   VORTEX_API void Advect();
 
+  /**
+   * @brief Record the advection of the density fields in a command buffer.
+   * Does nothing if no density field was bound.
+   * @param commandBuffer command buffer to record into
+   */
+  VORTEX_API void Advect(vk::CommandBuffer commandBuffer);
+
   /**
    * @brief Binds praticles to be advected.
    * Also use a level set to project out the particles if they enter it.
@@ -69,16 +107,29 @@ public:
    */
   VORTEX_API void AdvectParticles();
 
+  /**
+   * @brief Record the advection of the particles in a command buffer.
+   * @param commandBuffer command buffer to record into
+   */
+  VORTEX_API void AdvectParticles(vk::CommandBuffer commandBuffer);
+
 private:
+  void BindDensities();
+
   const Renderer::Device& mDevice;
   float mDt;
   glm::ivec2 mSize;
   Velocity& mVelocity;
+  std::vector<Density*> mDensities;
+  Renderer::GenericBuffer* mParticles;
+  Renderer::IndirectBuffer<Renderer::DispatchParams>* mDispatchParams;
+  vk::UniqueSampler mSampler;
+  Velocity::InterpolationMode mInterpolationMode;
 
   Renderer::Work mVelocityAdvect;
   Renderer::Work::Bound mVelocityAdvectBound;
   Renderer::Work mAdvect;
-  Renderer::Work::Bound mAdvectBound;
+  std::vector<Renderer::Work::Bound> mAdvectBounds;
   Renderer::Work mAdvectParticles;
   Renderer::Work::Bound mAdvectParticlesBound;
 
@@ -14,43 +14,67 @@ Extrapolation::Extrapolation(const Renderer::Device& device,
                              const glm::ivec2& size,
                              Renderer::GenericBuffer& valid,
                              Velocity& velocity,
-                             int iterations)
+                             int iterations,
+                             Method method)
     : mDevice(device)
-    , mValid(device, size.x * size.y)
+    , mIterations(iterations)
+    , mSourceValid(valid)
     , mVelocity(velocity)
-    , mExtrapolateVelocity(device, size, SPIRV::ExtrapolateVelocity_comp)
-    , mExtrapolateVelocityBound(
-          mExtrapolateVelocity.Bind({valid, mValid, velocity, velocity.Output()}))
-    , mExtrapolateVelocityBackBound(
-          mExtrapolateVelocity.Bind({mValid, valid, velocity.Output(), velocity}))
     , mConstrainVelocity(device, size, SPIRV::ConstrainVelocity_comp)
     , mExtrapolateCmd(device, false)
     , mConstrainCmd(device, false)
 {
-  mExtrapolateCmd.Record([&, iterations](vk::CommandBuffer commandBuffer) {
-    commandBuffer.debugMarkerBeginEXT({"Extrapolate", {{0.60f, 0.87f, 0.12f, 1.0f}}},
-                                      mDevice.Loader());
-    for (int i = 0; i < iterations / 2; i++)
-    {
-      mExtrapolateVelocityBound.Record(commandBuffer);
-      velocity.Output().Barrier(commandBuffer,
-                                vk::ImageLayout::eGeneral,
-                                vk::AccessFlagBits::eShaderWrite,
-                                vk::ImageLayout::eGeneral,
-                                vk::AccessFlagBits::eShaderRead);
-      mValid.Barrier(
-          commandBuffer, vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead);
-      mExtrapolateVelocityBackBound.Record(commandBuffer);
-      velocity.Barrier(commandBuffer,
-                       vk::ImageLayout::eGeneral,
-                       vk::AccessFlagBits::eShaderWrite,
-                       vk::ImageLayout::eGeneral,
-                       vk::AccessFlagBits::eShaderRead);
-      valid.Barrier(
-          commandBuffer, vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead);
-    }
-    commandBuffer.debugMarkerEndEXT(mDevice.Loader());
-  });
+  if (method == Method::Front)
+  {
+    mFront = std::make_unique<FrontMethod>(device, size, valid, velocity);
+  }
+  else
+  {
+    mGrid = std::make_unique<GridMethod>(device, size, valid, velocity);
+  }
+
+  mExtrapolateCmd.Record([&](vk::CommandBuffer commandBuffer) { Extrapolate(commandBuffer); });
+}
+
+Extrapolation::GridMethod::GridMethod(const Renderer::Device& device,
+                                      const glm::ivec2& size,
+                                      Renderer::GenericBuffer& valid,
+                                      Velocity& velocity)
+    : Valid(device, size.x * size.y)
+    , ExtrapolateVelocity(device, size, SPIRV::ExtrapolateVelocity_comp)
+    , ExtrapolateVelocityBound(
+          ExtrapolateVelocity.Bind({valid, Valid, velocity, velocity.Output()}))
+    , ExtrapolateVelocityBackBound(
+          ExtrapolateVelocity.Bind({Valid, valid, velocity.Output(), velocity}))
+{
+}
+
+Extrapolation::FrontMethod::FrontMethod(const Renderer::Device& device,
+                                        const glm::ivec2& size,
+                                        Renderer::GenericBuffer& valid,
+                                        Velocity& velocity)
+    : Front(device, size.x * size.y)
+    , FrontIndex(device, size.x * size.y)
+    , FrontList(device, size.x * size.y)
+    , NewFrontList(device, size.x * size.y)
+    , FrontParams(device)
+    , NewFrontParams(device)
+    , InitWork(device, size, SPIRV::ExtrapolateFrontInit_comp)
+    , InitBound(InitWork.Bind({valid, Front}))
+    , Scan(device, size.x * size.y)
+    , ScanBound(Scan.Bind(Front, FrontIndex, FrontParams))
+    , ListWork(device, size, SPIRV::ExtrapolateFrontList_comp)
+    , ListBound(ListWork.Bind({Front, FrontIndex, FrontList}))
+    , ExtrapolateWork(device, Renderer::ComputeSize::Default1D(), SPIRV::ExtrapolateFront_comp)
+    , ExtrapolateBound(ExtrapolateWork.Bind(size, {FrontParams, FrontList, valid, velocity}))
+    , NewExtrapolateBound(
+          ExtrapolateWork.Bind(size, {NewFrontParams, NewFrontList, valid, velocity}))
+    , AdvanceWork(device, Renderer::ComputeSize::Default1D(), SPIRV::ExtrapolateFrontAdvance_comp)
+    , AdvanceBound(AdvanceWork.Bind(
+          size, {FrontParams, FrontList, valid, Front, NewFrontParams, NewFrontList}))
+    , NewAdvanceBound(AdvanceWork.Bind(
+          size, {NewFrontParams, NewFrontList, valid, Front, FrontParams, FrontList}))
+{
 }
 
 void Extrapolation::Extrapolate()
@@ -62,13 +86,7 @@ void Extrapolation::ConstrainBind(Renderer::Texture& solidPhi)
 {
   mConstrainVelocityBound = mConstrainVelocity.Bind({solidPhi, mVelocity, mVelocity.Output()});
 
-  mConstrainCmd.Record([&](vk::CommandBuffer commandBuffer) {
-    commandBuffer.debugMarkerBeginEXT({"Constrain Velocity", {{0.82f, 0.20f, 0.20f, 1.0f}}},
-                                      mDevice.Loader());
-    mConstrainVelocityBound.Record(commandBuffer);
-    mVelocity.CopyBack(commandBuffer);
-    commandBuffer.debugMarkerEndEXT(mDevice.Loader());
-  });
+  mConstrainCmd.Record([&](vk::CommandBuffer commandBuffer) { ConstrainVelocity(commandBuffer); });
 }
 
 void Extrapolation::ConstrainVelocity()
@@ -76,5 +94,101 @@ void Extrapolation::ConstrainVelocity()
   mConstrainCmd.Submit();
 }
 
+void Extrapolation::Extrapolate(vk::CommandBuffer commandBuffer)
+{
+  commandBuffer.debugMarkerBeginEXT({"Extrapolate", {{0.60f, 0.87f, 0.12f, 1.0f}}},
+                                    mDevice.Loader());
+  if (mFront)
+  {
+    RecordFront(commandBuffer);
+  }
+  else
+  {
+    RecordGrid(commandBuffer);
+  }
+  commandBuffer.debugMarkerEndEXT(mDevice.Loader());
+}
+
+void Extrapolation::RecordGrid(vk::CommandBuffer commandBuffer)
+{
+  for (int i = 0; i < mIterations / 2; i++)
+  {
+    mGrid->ExtrapolateVelocityBound.Record(commandBuffer);
+    mVelocity.Output().Barrier(commandBuffer,
+                               vk::ImageLayout::eGeneral,
+                               vk::AccessFlagBits::eShaderWrite,
+                               vk::ImageLayout::eGeneral,
+                               vk::AccessFlagBits::eShaderRead);
+    mGrid->Valid.Barrier(
+        commandBuffer, vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead);
+    mGrid->ExtrapolateVelocityBackBound.Record(commandBuffer);
+    mVelocity.Barrier(commandBuffer,
+                      vk::ImageLayout::eGeneral,
+                      vk::AccessFlagBits::eShaderWrite,
+                      vk::ImageLayout::eGeneral,
+                      vk::AccessFlagBits::eShaderRead);
+    mSourceValid.Barrier(
+        commandBuffer, vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead);
+  }
+}
+
+void Extrapolation::RecordFront(vk::CommandBuffer commandBuffer)
+{
+  auto& front = *mFront;
+
+  // compact list of the cells next to the valid values
+  front.InitBound.Record(commandBuffer);
+  front.Front.Barrier(
+      commandBuffer, vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead);
+  front.ScanBound.Record(commandBuffer);
+  front.ListBound.Record(commandBuffer);
+  front.FrontList.Barrier(
+      commandBuffer, vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead);
+
+  // each layer extrapolates the cells of the list in place, and appends their
+  // neighbours that are still missing values to the other list. The layer
+  // number marks the cells already added, it starts above the initial marks.
+  for (int i = 0; i < mIterations; i++)
+  {
+    bool even = i % 2 == 0;
+    auto& params = even ? front.FrontParams : front.NewFrontParams;
+    auto& newParams = even ? front.NewFrontParams : front.FrontParams;
+    auto& newList = even ? front.NewFrontList : front.FrontList;
+    auto& extrapolateBound = even ? front.ExtrapolateBound : front.NewExtrapolateBound;
+    auto& advanceBound = even ? front.AdvanceBound : front.NewAdvanceBound;
+
+    extrapolateBound.RecordIndirect(commandBuffer, params);
+    mVelocity.Barrier(commandBuffer,
+                      vk::ImageLayout::eGeneral,
+                      vk::AccessFlagBits::eShaderWrite,
+                      vk::ImageLayout::eGeneral,
+                      vk::AccessFlagBits::eShaderRead);
+    mSourceValid.Barrier(
+        commandBuffer, vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead);
+
+    newParams.Clear(commandBuffer);
+    advanceBound.PushConstant(commandBuffer, i + 2);
+    advanceBound.RecordIndirect(commandBuffer, params);
+    mSourceValid.Barrier(
+        commandBuffer, vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead);
+    front.Front.Barrier(
+        commandBuffer, vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead);
+    newList.Barrier(
+        commandBuffer, vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead);
+    newParams.Barrier(commandBuffer,
+                      vk::AccessFlagBits::eShaderWrite,
+                      vk::AccessFlagBits::eIndirectCommandRead | vk::AccessFlagBits::eShaderRead);
+  }
+}
+
+void Extrapolation::ConstrainVelocity(vk::CommandBuffer commandBuffer)
+{
+  commandBuffer.debugMarkerBeginEXT({"Constrain Velocity", {{0.82f, 0.20f, 0.20f, 1.0f}}},
+                                    mDevice.Loader());
+  mConstrainVelocityBound.Record(commandBuffer);
+  mVelocity.CopyBack(commandBuffer);
+  commandBuffer.debugMarkerEndEXT(mDevice.Loader());
+}
+
 }  // namespace Fluid
 }  // namespace Vortex
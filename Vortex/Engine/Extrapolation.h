@@ -6,10 +6,13 @@
 #pragma once
 
 #include <Vortex/Engine/LevelSet.h>
+#include <Vortex/Engine/PrefixScan.h>
 #include <Vortex/Engine/Velocity.h>
 #include <Vortex/Renderer/CommandBuffer.h>
 #include <Vortex/Renderer/Work.h>
 
+#include <memory>
+
 namespace Vortex
 {
 namespace Fluid
@@ -21,11 +24,37 @@ namespace Fluid
 class Extrapolation
 {
 public:
+  /**
+   * @brief How the values are extrapolated.
+   */
+  enum class Method
+  {
+    /**
+     * @brief Each iteration extrapolates one layer over the whole grid.
+     */
+    Grid,
+    /**
+     * @brief Each iteration extrapolates one layer from the list of cells on
+     * the front of the valid values, which then advances outwards.
+     */
+    Front,
+  };
+
+  /**
+   * @brief Initialize the extrapolation.
+   * @param device vulkan device
+   * @param size size of the velocity field
+   * @param valid buffer of the valid velocity values
+   * @param velocity the velocity field
+   * @param iterations number of layers extrapolated, i.e. the band width
+   * @param method how the values are extrapolated
+   */
   VORTEX_API Extrapolation(const Renderer::Device& device,
                            const glm::ivec2& size,
                            Renderer::GenericBuffer& valid,
                            Velocity& velocity,
-                           int iterations = 10);
+                           int iterations = 10,
+                           Method method = Method::Grid);
 
   /**
    * @brief Will extrapolate values from buffer into the dirichlet and neumann
@@ -33,6 +62,12 @@ public:
    */
   VORTEX_API void Extrapolate();
 
+  /**
+   * @brief Record the extrapolation in a command buffer.
+   * @param commandBuffer command buffer to record into
+   */
+  VORTEX_API void Extrapolate(vk::CommandBuffer commandBuffer);
+
   /**
    * @brief Binds a solid level set to use later and constrain the velocity
    * against
@@ -46,13 +81,67 @@ public:
    */
   VORTEX_API void ConstrainVelocity();
 
+  /**
+   * @brief Record the velocity constrain in a command buffer.
+   * @param commandBuffer command buffer to record into
+   */
+  VORTEX_API void ConstrainVelocity(vk::CommandBuffer commandBuffer);
+
 private:
+  /**
+   * @brief The buffers and kernels of the grid method, only created if it is
+   * used.
+   */
+  struct GridMethod
+  {
+    GridMethod(const Renderer::Device& device,
+               const glm::ivec2& size,
+               Renderer::GenericBuffer& valid,
+               Velocity& velocity);
+
+    Renderer::Buffer<glm::ivec2> Valid;
+    Renderer::Work ExtrapolateVelocity;
+    Renderer::Work::Bound ExtrapolateVelocityBound, ExtrapolateVelocityBackBound;
+  };
+
+  /**
+   * @brief The lists of the front and the kernels advancing it, only created
+   * if the front method is used.
+   */
+  struct FrontMethod
+  {
+    FrontMethod(const Renderer::Device& device,
+                const glm::ivec2& size,
+                Renderer::GenericBuffer& valid,
+                Velocity& velocity);
+
+    Renderer::Buffer<int> Front;
+    Renderer::Buffer<int> FrontIndex;
+    Renderer::Buffer<int> FrontList, NewFrontList;
+    Renderer::IndirectBuffer<Renderer::DispatchParams> FrontParams, NewFrontParams;
+    Renderer::Work InitWork;
+    Renderer::Work::Bound InitBound;
+    PrefixScan Scan;
+    PrefixScan::Bound ScanBound;
+    Renderer::Work ListWork;
+    Renderer::Work::Bound ListBound;
+    Renderer::Work ExtrapolateWork;
+    Renderer::Work::Bound ExtrapolateBound, NewExtrapolateBound;
+    Renderer::Work AdvanceWork;
+    Renderer::Work::Bound AdvanceBound, NewAdvanceBound;
+  };
+
+  void RecordGrid(vk::CommandBuffer commandBuffer);
+  void RecordFront(vk::CommandBuffer commandBuffer);
+
   const Renderer::Device& mDevice;
-  Renderer::Buffer<glm::ivec2> mValid;
+  int mIterations;
+  Renderer::GenericBuffer& mSourceValid;
   Velocity& mVelocity;
 
-  Renderer::Work mExtrapolateVelocity;
-  Renderer::Work::Bound mExtrapolateVelocityBound, mExtrapolateVelocityBackBound;
+  std::unique_ptr<GridMethod> mGrid;
+  std::unique_ptr<FrontMethod> mFront;
+
   Renderer::Work mConstrainVelocity;
   Renderer::Work::Bound mConstrainVelocityBound;
 
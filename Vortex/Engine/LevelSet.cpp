@@ -14,11 +14,25 @@ namespace Vortex
 {
 namespace Fluid
 {
+namespace
+{
+// size of the square tiles of the narrow band, one work group each
+const int TileSize = 8;
+
+glm::ivec2 GetTilesSize(const glm::ivec2& size)
+{
+  return (size + glm::ivec2(TileSize - 1)) / glm::ivec2(TileSize);
+}
+}  // namespace
+
 LevelSet::LevelSet(const Renderer::Device& device,
                    const glm::ivec2& size,
-                   int reinitializeIterations)
+                   int reinitializeIterations,
+                   float bandWidth)
     : Renderer::RenderTexture(device, size.x, size.y, vk::Format::eR32Sfloat)
     , mDevice(device)
+    , mReinitializeIterations(reinitializeIterations)
+    , mBandWidth(bandWidth)
     , mLevelSet0(device, size.x, size.y, vk::Format::eR32Sfloat)
     , mLevelSetBack(device, size.x, size.y, vk::Format::eR32Sfloat)
     , mSampler(Renderer::SamplerBuilder()
@@ -32,38 +46,22 @@ LevelSet::LevelSet(const Renderer::Device& device,
           mRedistance.Bind({{*mSampler, mLevelSet0}, {*mSampler, mLevelSetBack}, *this}))
     , mExtrapolateCmd(device, false)
     , mReinitialiseCmd(device, false)
+    , mVersion(0)
 {
-  mReinitialiseCmd.Record([&, reinitializeIterations](vk::CommandBuffer commandBuffer) {
-    commandBuffer.debugMarkerBeginEXT({"Reinitialise", {{0.98f, 0.49f, 0.26f, 1.0f}}},
-                                      mDevice.Loader());
-
-    mLevelSet0.CopyFrom(commandBuffer, *this);
+  if (mBandWidth > 0.0f)
+  {
+    mNarrowBand = std::make_unique<NarrowBand>(
+        device, size, *mSampler, *this, mLevelSet0, mLevelSetBack);
+  }
 
-    for (int i = 0; i < reinitializeIterations / 2; i++)
-    {
-      mRedistanceFront.PushConstant(commandBuffer, 0.1f);
-      mRedistanceFront.Record(commandBuffer);
-      mLevelSetBack.Barrier(commandBuffer,
-                            vk::ImageLayout::eGeneral,
-                            vk::AccessFlagBits::eShaderWrite,
-                            vk::ImageLayout::eGeneral,
-                            vk::AccessFlagBits::eShaderRead);
-      mRedistanceBack.PushConstant(commandBuffer, 0.1f);
-      mRedistanceBack.Record(commandBuffer);
-      Barrier(commandBuffer,
-              vk::ImageLayout::eGeneral,
-              vk::AccessFlagBits::eShaderWrite,
-              vk::ImageLayout::eGeneral,
-              vk::AccessFlagBits::eShaderRead);
-    }
-
-    commandBuffer.debugMarkerEndEXT(mDevice.Loader());
-  });
+  mReinitialiseCmd.Record([&](vk::CommandBuffer commandBuffer) { Reinitialise(commandBuffer); });
 }
 
 LevelSet::LevelSet(LevelSet&& other)
     : Renderer::RenderTexture(std::move(other))
     , mDevice(other.mDevice)
+    , mReinitializeIterations(other.mReinitializeIterations)
+    , mBandWidth(other.mBandWidth)
     , mLevelSet0(std::move(other.mLevelSet0))
     , mLevelSetBack(std::move(other.mLevelSetBack))
     , mSampler(std::move(other.mSampler))
@@ -72,35 +70,164 @@ LevelSet::LevelSet(LevelSet&& other)
     , mRedistance(std::move(other.mRedistance))
     , mRedistanceFront(std::move(other.mRedistanceFront))
     , mRedistanceBack(std::move(other.mRedistanceBack))
+    , mNarrowBand(std::move(other.mNarrowBand))
     , mExtrapolateCmd(std::move(other.mExtrapolateCmd))
     , mReinitialiseCmd(std::move(other.mReinitialiseCmd))
+    , mVersion(other.mVersion)
+{
+}
+
+LevelSet::NarrowBand::NarrowBand(const Renderer::Device& device,
+                                 const glm::ivec2& size,
+                                 vk::Sampler sampler,
+                                 Renderer::Texture& levelSet,
+                                 Renderer::Texture& levelSet0,
+                                 Renderer::Texture& levelSetBack)
+    : TilesSize(GetTilesSize(size))
+    , Band(device, TilesSize.x * TilesSize.y)
+    , Index(device, TilesSize.x * TilesSize.y)
+    , ScanParams(device)
+    , Params(device)
+    , Tiles(device, TilesSize.x * TilesSize.y)
+    , BandWork(device,
+               size,
+               SPIRV::NarrowBand_comp,
+               Renderer::SpecConst(Renderer::SpecConstValue(3, TileSize)))
+    , BandBound(BandWork.Bind({levelSet, levelSet0, Band}))
+    , Scan(device, TilesSize.x * TilesSize.y)
+    , ScanBound(Scan.Bind(Band, Index, ScanParams))
+    , TilesWork(device, TilesSize.x * TilesSize.y, SPIRV::NarrowBandTiles_comp)
+    , TilesBound(TilesWork.Bind({Band, Index, ScanParams, Tiles, Params}))
+    , Redistance(device,
+                 Renderer::ComputeSize(size, glm::ivec2(TileSize)),
+                 SPIRV::RedistanceBand_comp)
+    , RedistanceFront(Redistance.Bind(
+          {{sampler, levelSet0}, {sampler, levelSet}, levelSetBack, Tiles}))
+    , RedistanceBack(Redistance.Bind(
+          {{sampler, levelSet0}, {sampler, levelSetBack}, levelSet, Tiles}))
 {
 }
 
 void LevelSet::ExtrapolateBind(Renderer::Texture& solidPhi)
 {
   mExtrapolateBound = mExtrapolate.Bind({solidPhi, *this});
-  mExtrapolateCmd.Record([&](vk::CommandBuffer commandBuffer) {
-    commandBuffer.debugMarkerBeginEXT({"Extrapolate phi", {{0.53f, 0.09f, 0.16f, 1.0f}}},
-                                      mDevice.Loader());
-    mExtrapolateBound.Record(commandBuffer);
+  mExtrapolateCmd.Record([&](vk::CommandBuffer commandBuffer) { Extrapolate(commandBuffer); });
+}
+
+void LevelSet::Reinitialise()
+{
+  mReinitialiseCmd.Submit();
+  mVersion++;
+}
+
+void LevelSet::Extrapolate()
+{
+  mExtrapolateCmd.Submit();
+  mVersion++;
+}
+
+void LevelSet::Submit(Renderer::RenderCommand& renderCommand)
+{
+  Renderer::RenderTexture::Submit(renderCommand);
+  mVersion++;
+}
+
+uint64_t LevelSet::GetVersion() const
+{
+  return mVersion;
+}
+
+void LevelSet::Reinitialise(vk::CommandBuffer commandBuffer)
+{
+  commandBuffer.debugMarkerBeginEXT({"Reinitialise", {{0.98f, 0.49f, 0.26f, 1.0f}}},
+                                    mDevice.Loader());
+
+  if (mNarrowBand)
+  {
+    RecordNarrowBand(commandBuffer);
+  }
+  else
+  {
+    mLevelSet0.CopyFrom(commandBuffer, *this);
+  }
+
+  for (int i = 0; i < mReinitializeIterations / 2; i++)
+  {
+    if (mNarrowBand)
+    {
+      mNarrowBand->RedistanceFront.PushConstant(commandBuffer, 0.1f);
+      mNarrowBand->RedistanceFront.RecordIndirect(commandBuffer, mNarrowBand->Params);
+    }
+    else
+    {
+      mRedistanceFront.PushConstant(commandBuffer, 0.1f);
+      mRedistanceFront.Record(commandBuffer);
+    }
+    mLevelSetBack.Barrier(commandBuffer,
+                          vk::ImageLayout::eGeneral,
+                          vk::AccessFlagBits::eShaderWrite,
+                          vk::ImageLayout::eGeneral,
+                          vk::AccessFlagBits::eShaderRead);
+    if (mNarrowBand)
+    {
+      mNarrowBand->RedistanceBack.PushConstant(commandBuffer, 0.1f);
+      mNarrowBand->RedistanceBack.RecordIndirect(commandBuffer, mNarrowBand->Params);
+    }
+    else
+    {
+      mRedistanceBack.PushConstant(commandBuffer, 0.1f);
+      mRedistanceBack.Record(commandBuffer);
+    }
     Barrier(commandBuffer,
             vk::ImageLayout::eGeneral,
             vk::AccessFlagBits::eShaderWrite,
             vk::ImageLayout::eGeneral,
             vk::AccessFlagBits::eShaderRead);
-    commandBuffer.debugMarkerEndEXT(mDevice.Loader());
-  });
+  }
+
+  commandBuffer.debugMarkerEndEXT(mDevice.Loader());
 }
 
-void LevelSet::Reinitialise()
+void LevelSet::RecordNarrowBand(vk::CommandBuffer commandBuffer)
 {
-  mReinitialiseCmd.Submit();
+  // mark the tiles of the band and clamp the level set, the tiles outside
+  // the band are then left untouched by the redistancing.
+  mNarrowBand->Band.Clear(commandBuffer);
+  mNarrowBand->BandBound.PushConstant(commandBuffer, mBandWidth);
+  mNarrowBand->BandBound.Record(commandBuffer);
+  mNarrowBand->Band.Barrier(
+      commandBuffer, vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead);
+  mLevelSet0.Barrier(commandBuffer,
+                     vk::ImageLayout::eGeneral,
+                     vk::AccessFlagBits::eShaderWrite,
+                     vk::ImageLayout::eGeneral,
+                     vk::AccessFlagBits::eShaderRead);
+
+  CopyFrom(commandBuffer, mLevelSet0);
+  mLevelSetBack.CopyFrom(commandBuffer, mLevelSet0);
+
+  // compact list of the band tiles, and the indirect dispatch over them
+  mNarrowBand->ScanBound.Record(commandBuffer);
+  mNarrowBand->TilesBound.PushConstant(commandBuffer, mNarrowBand->TilesSize.x);
+  mNarrowBand->TilesBound.Record(commandBuffer);
+  mNarrowBand->Tiles.Barrier(
+      commandBuffer, vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead);
+  mNarrowBand->Params.Barrier(commandBuffer,
+                              vk::AccessFlagBits::eShaderWrite,
+                              vk::AccessFlagBits::eIndirectCommandRead);
 }
 
-void LevelSet::Extrapolate()
+void LevelSet::Extrapolate(vk::CommandBuffer commandBuffer)
 {
-  mExtrapolateCmd.Submit();
+  commandBuffer.debugMarkerBeginEXT({"Extrapolate phi", {{0.53f, 0.09f, 0.16f, 1.0f}}},
+                                    mDevice.Loader());
+  mExtrapolateBound.Record(commandBuffer);
+  Barrier(commandBuffer,
+          vk::ImageLayout::eGeneral,
+          vk::AccessFlagBits::eShaderWrite,
+          vk::ImageLayout::eGeneral,
+          vk::AccessFlagBits::eShaderRead);
+  commandBuffer.debugMarkerEndEXT(mDevice.Loader());
 }
 
 }  // namespace Fluid
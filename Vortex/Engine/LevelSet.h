@@ -5,10 +5,13 @@
 
 #pragma once
 
+#include <Vortex/Engine/PrefixScan.h>
 #include <Vortex/Renderer/CommandBuffer.h>
 #include <Vortex/Renderer/RenderTexture.h>
 #include <Vortex/Renderer/Work.h>
 
+#include <memory>
+
 namespace Vortex
 {
 namespace Fluid
@@ -20,9 +23,18 @@ namespace Fluid
 class LevelSet : public Renderer::RenderTexture
 {
 public:
+  /**
+   * @brief Construct a level set.
+   * @param device vulkan device
+   * @param size size of the level set
+   * @param reinitializeIterations number of iterations when re-initialising
+   * @param bandWidth if not zero, only the tiles within this distance of the
+   * interface are re-initialised, and the values are clamped to this distance.
+   */
   VORTEX_API LevelSet(const Renderer::Device& device,
                       const glm::ivec2& size,
-                      int reinitializeIterations = 50);
+                      int reinitializeIterations = 50,
+                      float bandWidth = 0.0f);
 
   VORTEX_API LevelSet(LevelSet&& other);
 
@@ -32,6 +44,12 @@ public:
    */
   VORTEX_API void Reinitialise();
 
+  /**
+   * @brief Record the re-initialisation of the level set in a command buffer.
+   * @param commandBuffer command buffer to record into
+   */
+  VORTEX_API void Reinitialise(vk::CommandBuffer commandBuffer);
+
   /**
    * @brief Bind a solid level set, which will be used to extrapolate into this
    * level set
@@ -45,8 +63,63 @@ public:
    */
   VORTEX_API void Extrapolate();
 
+  /**
+   * @brief Record the extrapolation in a command buffer.
+   * @param commandBuffer command buffer to record into
+   */
+  VORTEX_API void Extrapolate(vk::CommandBuffer commandBuffer);
+
+  /**
+   * @brief Submit a render command drawing in the level set.
+   * @param renderCommand the render command
+   */
+  VORTEX_API void Submit(Renderer::RenderCommand& renderCommand) override;
+
+  /**
+   * @brief Incremented each time the level set is changed by a submitted
+   * render command, reinitialisation or extrapolation. Changes recorded in
+   * other command buffers are not counted.
+   * @return the version
+   */
+  VORTEX_API uint64_t GetVersion() const;
+
 private:
+  /**
+   * @brief The tiles of the narrow band and the kernels to re-initialise
+   * them, only created if a band width is given.
+   */
+  struct NarrowBand
+  {
+    NarrowBand(const Renderer::Device& device,
+               const glm::ivec2& size,
+               vk::Sampler sampler,
+               Renderer::Texture& levelSet,
+               Renderer::Texture& levelSet0,
+               Renderer::Texture& levelSetBack);
+
+    glm::ivec2 TilesSize;
+    Renderer::Buffer<int> Band;
+    Renderer::Buffer<int> Index;
+    Renderer::IndirectBuffer<Renderer::DispatchParams> ScanParams;
+    Renderer::IndirectBuffer<Renderer::DispatchParams> Params;
+    Renderer::Buffer<glm::ivec2> Tiles;
+
+    Renderer::Work BandWork;
+    Renderer::Work::Bound BandBound;
+    PrefixScan Scan;
+    PrefixScan::Bound ScanBound;
+    Renderer::Work TilesWork;
+    Renderer::Work::Bound TilesBound;
+    Renderer::Work Redistance;
+    Renderer::Work::Bound RedistanceFront;
+    Renderer::Work::Bound RedistanceBack;
+  };
+
+  void RecordNarrowBand(vk::CommandBuffer commandBuffer);
+
   const Renderer::Device& mDevice;
+  int mReinitializeIterations;
+  float mBandWidth;
   Renderer::Texture mLevelSet0;
   Renderer::Texture mLevelSetBack;
 
@@ -58,8 +131,12 @@ private:
   Renderer::Work::Bound mRedistanceFront;
   Renderer::Work::Bound mRedistanceBack;
 
+  std::unique_ptr<NarrowBand> mNarrowBand;
+
   Renderer::CommandBuffer mExtrapolateCmd;
   Renderer::CommandBuffer mReinitialiseCmd;
+
+  uint64_t mVersion;
 };
 
 }  // namespace Fluid
@@ -6,22 +6,39 @@
 #include "ConjugateGradient.h"
 
 #include <Vortex/Engine/Rigidbody.h>
+#include <Vortex/Renderer/PipelineBarrier.h>
 
 #include "vortex_generated_spirv.h"
 
+#include <algorithm>
+
 namespace Vortex
 {
 namespace Fluid
 {
+namespace
+{
+// the domain kernels share the indirect dispatch calculated by the
+// convergence kernel with the default local size, which is then not tuned.
+Renderer::ComputeSize MakeDomainComputeSize(const glm::ivec2& size)
+{
+  Renderer::ComputeSize computeSize(size);
+  computeSize.WorkShape = Renderer::ComputeSize::Shape::Fixed;
+
+  return computeSize;
+}
+}  // namespace
+
 ConjugateGradient::ConjugateGradient(const Renderer::Device& device,
                                      const glm::ivec2& size,
                                      Preconditioner& preconditioner)
     : mDevice(device)
     , mPreconditioner(preconditioner)
+    , mDiv(nullptr)
+    , mPressure(nullptr)
     , r(device, size.x * size.y)
     , s(device, size.x * size.y)
     , z(device, size.x * size.y)
-    , inner(device, size.x * size.y)
     , alpha(device, 1)
     , beta(device, 1)
     , rho(device, 1)
@@ -29,29 +46,55 @@ ConjugateGradient::ConjugateGradient(const Renderer::Device& device,
     , sigma(device, 1)
     , error(device)
     , localError(device, 1, VMA_MEMORY_USAGE_GPU_TO_CPU)
-    , matrixMultiply(device, size, SPIRV::MultiplyMatrix_comp)
+    , initialError(device)
+    , localInitialError(device, 1, VMA_MEMORY_USAGE_GPU_TO_CPU)
+    , tolerance(device, 1, VMA_MEMORY_USAGE_CPU_ONLY)
+    , iterations(device)
+    , localIterations(device, 1, VMA_MEMORY_USAGE_GPU_TO_CPU)
+    , domainDispatch(device)
+    , scalarDispatch(device)
+    , matrixMultiply(device, MakeDomainComputeSize(size), SPIRV::MultiplyMatrix_comp)
     , scalarDivision(device, glm::ivec2(1), SPIRV::Divide_comp)
-    , scalarMultiply(device, size, SPIRV::Multiply_comp)
-    , multiplyAdd(device, size, SPIRV::MultiplyAdd_comp)
-    , multiplySub(device, size, SPIRV::MultiplySub_comp)
-    , reduceSum(device, size)
+    , multiplyAdd(device, MakeDomainComputeSize(size), SPIRV::MultiplyAdd_comp)
+    , multiplySub(device, MakeDomainComputeSize(size), SPIRV::MultiplySub_comp)
+    , residual(device, size, SPIRV::Residual_comp)
+    , convergence(device, glm::ivec2(1), SPIRV::Convergence_comp)
+    , mWorkSize(Renderer::ComputeSize::GetWorkSize(size))
+    , reduceInner(device, size)
     , reduceMax(device, size)
-    , reduceMaxBound(reduceMax.Bind(r, error))
-    , reduceSumRhoBound(reduceSum.Bind(inner, rho))
-    , reduceSumSigmaBound(reduceSum.Bind(inner, sigma))
-    , reduceSumRhoNewBound(reduceSum.Bind(inner, rho_new))
-    , multiplySBound(scalarMultiply.Bind({z, s, inner}))
-    , multiplyZBound(scalarMultiply.Bind({z, r, inner}))
+    , reduceMaxBound(reduceMax.Bind(r, initialError))
+    , reduceRhoBound(reduceInner.Bind(z, r, rho, error))
+    , reduceSigmaBound(reduceInner.Bind(z, s, sigma))
+    , reduceRhoNewBound(reduceInner.Bind(z, r, rho_new, error))
     , divideRhoBound(scalarDivision.Bind({rho, sigma, alpha}))
     , divideRhoNewBound(scalarDivision.Bind({rho_new, rho, beta}))
     , multiplySubRBound(multiplySub.Bind({r, z, alpha, r}))
     , multiplyAddZBound(multiplyAdd.Bind({z, s, beta, s}))
+    , convergenceBound(convergence.Bind(
+          {error, initialError, tolerance, iterations, domainDispatch, scalarDispatch}))
+    , mWarmStart(device, size)
+    , mSolveStart(device, false)
+    , mSolveWarmStart(device)
     , mSolveInit(device, false)
     , mSolve(device, false)
+    , mSolveInitChecked(device, false)
+    , mSolveChecked(device, false)
     , mErrorRead(device)
+    , mInitRead(device)
+    , mConvergenceRead(device)
 {
   mErrorRead.Record(
       [&](vk::CommandBuffer commandBuffer) { localError.CopyFrom(commandBuffer, error); });
+
+  mInitRead.Record([&](vk::CommandBuffer commandBuffer) {
+    localError.CopyFrom(commandBuffer, error);
+    localInitialError.CopyFrom(commandBuffer, initialError);
+  });
+
+  mConvergenceRead.Record([&](vk::CommandBuffer commandBuffer) {
+    localError.CopyFrom(commandBuffer, error);
+    localIterations.CopyFrom(commandBuffer, iterations);
+  });
 }
 
 ConjugateGradient::~ConjugateGradient() {}
@@ -65,90 +108,21 @@ void ConjugateGradient::Bind(Renderer::GenericBuffer& d,
 
   matrixMultiplyBound = matrixMultiply.Bind({d, l, s, z});
   multiplyAddPBound = multiplyAdd.Bind({pressure, s, alpha, pressure});
+  residualBound = residual.Bind({pressure, d, l, b, r});
+  mWarmStart.Bind(d, pressure);
 
-  mSolveInit.Record([&](vk::CommandBuffer commandBuffer) {
-    commandBuffer.debugMarkerBeginEXT({"PCG Init", {{0.63f, 0.04f, 0.66f, 1.0f}}},
-                                      mDevice.Loader());
-
-    // r = b
-    r.CopyFrom(commandBuffer, b);
-
-    // calculate error
-    reduceMaxBound.Record(commandBuffer);
-
-    // p = 0
-    pressure.Clear(commandBuffer);
-
-    // z = M^-1 r
-    z.Clear(commandBuffer);
-    mPreconditioner.Record(commandBuffer);
-    z.Barrier(commandBuffer, vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead);
-
-    // s = z
-    s.CopyFrom(commandBuffer, z);
-
-    // rho = zTr
-    multiplyZBound.Record(commandBuffer);
-    inner.Barrier(commandBuffer, vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead);
-    reduceSumRhoBound.Record(commandBuffer);
-    z.Clear(commandBuffer);
-
-    commandBuffer.debugMarkerEndEXT(mDevice.Loader());
-  });
-
-  mSolve.Record([&](vk::CommandBuffer commandBuffer) {
-    commandBuffer.debugMarkerBeginEXT({"PCG Step", {{0.51f, 0.90f, 0.72f, 1.0f}}},
-                                      mDevice.Loader());
-
-    // z = As
-    matrixMultiplyBound.Record(commandBuffer);
-    z.Barrier(commandBuffer, vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead);
-
-    // sigma = zTs
-    multiplySBound.Record(commandBuffer);
-    inner.Barrier(commandBuffer, vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead);
-    reduceSumSigmaBound.Record(commandBuffer);
-
-    // alpha = rho / sigma
-    divideRhoBound.Record(commandBuffer);
-    alpha.Barrier(commandBuffer, vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead);
-
-    // p = p + alpha * s
-    multiplyAddPBound.Record(commandBuffer);
-    pressure.Barrier(
-        commandBuffer, vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead);
-
-    // r = r - alpha * z
-    multiplySubRBound.Record(commandBuffer);
-    r.Barrier(commandBuffer, vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead);
-
-    // calculate max error
-    reduceMaxBound.Record(commandBuffer);
-
-    // z = M^-1 r
-    z.Clear(commandBuffer);
-    mPreconditioner.Record(commandBuffer);
-    z.Barrier(commandBuffer, vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead);
-
-    // rho_new = zTr
-    multiplyZBound.Record(commandBuffer);
-    inner.Barrier(commandBuffer, vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead);
-    reduceSumRhoNewBound.Record(commandBuffer);
-
-    // beta = rho_new / rho
-    divideRhoNewBound.Record(commandBuffer);
-    beta.Barrier(commandBuffer, vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead);
-
-    // s = z + beta * s
-    multiplyAddZBound.Record(commandBuffer);
-    z.Clear(commandBuffer);
-    s.Barrier(commandBuffer, vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead);
+  mDiv = &b;
+  mPressure = &pressure;
 
-    // rho = rho_new
-    rho.CopyFrom(commandBuffer, rho_new);
+  mSolveStart.Record([&](vk::CommandBuffer commandBuffer) { RecordStart(commandBuffer, false); });
+  mSolveWarmStart.Record(
+      [&](vk::CommandBuffer commandBuffer) { RecordStart(commandBuffer, true); });
+  mSolveInit.Record([&](vk::CommandBuffer commandBuffer) { RecordInit(commandBuffer, false); });
+  mSolve.Record([&](vk::CommandBuffer commandBuffer) { RecordStep(commandBuffer, false); });
 
-    commandBuffer.debugMarkerEndEXT(mDevice.Loader());
-  });
+  mSolveInitChecked.Record(
+      [&](vk::CommandBuffer commandBuffer) { RecordInit(commandBuffer, true); });
+  mSolveChecked.Record([&](vk::CommandBuffer commandBuffer) { RecordStep(commandBuffer, true); });
 }
 
 void ConjugateGradient::BindRigidbody(float delta, Renderer::GenericBuffer& d, RigidBody& rigidBody)
@@ -158,15 +132,25 @@ void ConjugateGradient::BindRigidbody(float delta, Renderer::GenericBuffer& d, R
 
 void ConjugateGradient::Solve(Parameters& params, const std::vector<RigidBody*>& rigidbodies)
 {
+  if (params.Type == Parameters::SolverType::Iterative && params.ErrorCheckInterval > 1)
+  {
+    SolveChecked(params, rigidbodies);
+    return;
+  }
+
   params.Reset();
 
+  SubmitStart(params, rigidbodies);
   mSolveInit.Submit();
 
+  // the error is relative to the one of a zero initial guess, i.e. max(|b|)
+  float initialError = 0.0f;
   if (params.Type == Parameters::SolverType::Iterative)
   {
-    mErrorRead.Submit().Wait();
+    mInitRead.Submit().Wait();
 
     Renderer::CopyTo(localError, params.OutError);
+    Renderer::CopyTo(localInitialError, initialError);
     if (params.OutError <= params.ErrorTolerance)
     {
       return;
@@ -175,7 +159,6 @@ void ConjugateGradient::Solve(Parameters& params, const std::vector<RigidBody*>&
     mErrorRead.Submit();
   }
 
-  auto initialError = params.OutError;
   for (unsigned i = 0; !params.IsFinished(initialError); params.OutIterations = ++i)
   {
     for (auto& rigidbody : rigidbodies)
@@ -194,6 +177,226 @@ void ConjugateGradient::Solve(Parameters& params, const std::vector<RigidBody*>&
   }
 }
 
+void ConjugateGradient::SolveChecked(Parameters& params, const std::vector<RigidBody*>& rigidbodies)
+{
+  params.Reset();
+
+  // the previous solve waited on its last read, the tolerance is not in use anymore
+  Renderer::CopyFrom(tolerance,
+                     glm::vec2(params.ErrorTolerance, params.Iterations > 0 ? 1.0f : 0.0f));
+
+  SubmitStart(params, rigidbodies);
+  mSolveInitChecked.Submit();
+  mInitRead.Submit().Wait();
+
+  float initialError;
+  Renderer::CopyTo(localError, params.OutError);
+  Renderer::CopyTo(localInitialError, initialError);
+  if (params.OutError <= params.ErrorTolerance)
+  {
+    return;
+  }
+
+  for (unsigned i = 1;; i++)
+  {
+    for (auto& rigidbody : rigidbodies)
+    {
+      rigidbody->Pressure();
+    }
+
+    mSolveChecked.Submit();
+
+    if (i % params.ErrorCheckInterval == 0 || i == params.Iterations)
+    {
+      mConvergenceRead.Submit().Wait();
+
+      int gpuIterations;
+      Renderer::CopyTo(localError, params.OutError);
+      Renderer::CopyTo(localIterations, gpuIterations);
+      params.OutIterations = static_cast<unsigned>(gpuIterations);
+
+      // the GPU stops counting iterations once converged
+      if (params.IsFinished(initialError) || params.OutIterations < i)
+      {
+        return;
+      }
+    }
+  }
+}
+
+void ConjugateGradient::SubmitStart(const Parameters& params,
+                                    const std::vector<RigidBody*>& rigidbodies)
+{
+  // the residual of the initial guess doesn't include the rigidbody coupling
+  bool strongCoupling =
+      std::any_of(rigidbodies.begin(), rigidbodies.end(), [](RigidBody* rigidbody) {
+        return rigidbody->GetType() == RigidBody::Type::eStrong;
+      });
+
+  if (params.WarmStart && !strongCoupling)
+  {
+    mSolveWarmStart.Wait();
+    mWarmStart.SetScale(params.WarmStartScale);
+    mSolveWarmStart.Submit();
+  }
+  else
+  {
+    mSolveStart.Submit();
+  }
+}
+
+void ConjugateGradient::RecordSolve(vk::CommandBuffer commandBuffer, unsigned iterations)
+{
+  RecordStart(commandBuffer, false);
+  RecordInit(commandBuffer, false);
+  for (unsigned i = 0; i < iterations; i++)
+  {
+    RecordStep(commandBuffer, false);
+  }
+}
+
+void ConjugateGradient::RecordStart(vk::CommandBuffer commandBuffer, bool warmStart)
+{
+  assert(mDiv != nullptr && mPressure != nullptr);
+
+  // r = b
+  r.CopyFrom(commandBuffer, *mDiv);
+
+  // calculate error of a zero initial guess
+  reduceMaxBound.Record(commandBuffer);
+
+  if (warmStart)
+  {
+    // p = previous solution, r = b - Ap
+    mWarmStart.Record(commandBuffer);
+    residualBound.Record(commandBuffer);
+    Renderer::ComputeBarrier(commandBuffer, {r});
+  }
+  else
+  {
+    // p = 0
+    mPressure->Clear(commandBuffer);
+  }
+}
+
+void ConjugateGradient::RecordInit(vk::CommandBuffer commandBuffer, bool checkConvergence)
+{
+  commandBuffer.debugMarkerBeginEXT({"PCG Init", {{0.63f, 0.04f, 0.66f, 1.0f}}},
+                                    mDevice.Loader());
+
+  // z = M^-1 r
+  z.Clear(commandBuffer);
+  mPreconditioner.Record(commandBuffer);
+  Renderer::ComputeBarrier(commandBuffer, {z});
+
+  // s = z
+  s.CopyFrom(commandBuffer, z);
+
+  // rho = zTr and calculate error
+  reduceRhoBound.Record(commandBuffer);
+  z.Clear(commandBuffer);
+
+  if (checkConvergence)
+  {
+    RecordConvergence(commandBuffer, 0);
+  }
+
+  commandBuffer.debugMarkerEndEXT(mDevice.Loader());
+}
+
+void ConjugateGradient::RecordStep(vk::CommandBuffer commandBuffer, bool checkConvergence)
+{
+  commandBuffer.debugMarkerBeginEXT({"PCG Step", {{0.51f, 0.90f, 0.72f, 1.0f}}},
+                                    mDevice.Loader());
+
+  // once converged, the update dispatches have zero groups. The preconditioner
+  // and the reductions still run until the next read of the error.
+  auto record = [&](Renderer::Work::Bound& bound) {
+    if (checkConvergence)
+    {
+      bound.RecordIndirect(commandBuffer, domainDispatch);
+    }
+    else
+    {
+      bound.Record(commandBuffer);
+    }
+  };
+
+  auto recordScalar = [&](Renderer::Work::Bound& bound) {
+    if (checkConvergence)
+    {
+      bound.RecordIndirect(commandBuffer, scalarDispatch);
+    }
+    else
+    {
+      bound.Record(commandBuffer);
+    }
+  };
+
+  // z = As
+  record(matrixMultiplyBound);
+  Renderer::ComputeBarrier(commandBuffer, {z});
+
+  // sigma = zTs
+  reduceSigmaBound.Record(commandBuffer);
+
+  // alpha = rho / sigma
+  recordScalar(divideRhoBound);
+  Renderer::ComputeBarrier(commandBuffer, {alpha});
+
+  // p = p + alpha * s
+  record(multiplyAddPBound);
+
+  // r = r - alpha * z
+  record(multiplySubRBound);
+  Renderer::ComputeBarrier(commandBuffer, {*mPressure, r});
+
+  // z = M^-1 r
+  z.Clear(commandBuffer);
+  mPreconditioner.Record(commandBuffer);
+  Renderer::ComputeBarrier(commandBuffer, {z});
+
+  // rho_new = zTr and calculate max error
+  reduceRhoNewBound.Record(commandBuffer);
+
+  if (checkConvergence)
+  {
+    RecordConvergence(commandBuffer, 1);
+  }
+
+  // beta = rho_new / rho
+  recordScalar(divideRhoNewBound);
+  Renderer::ComputeBarrier(commandBuffer, {beta});
+
+  // s = z + beta * s
+  record(multiplyAddZBound);
+  z.Clear(commandBuffer);
+  Renderer::ComputeBarrier(commandBuffer, {s});
+
+  // rho = rho_new
+  rho.CopyFrom(commandBuffer, rho_new);
+
+  commandBuffer.debugMarkerEndEXT(mDevice.Loader());
+}
+
+void ConjugateGradient::RecordConvergence(vk::CommandBuffer commandBuffer, int step)
+{
+  convergenceBound.PushConstant(commandBuffer, step, mWorkSize.x, mWorkSize.y);
+  convergenceBound.Record(commandBuffer);
+
+  Renderer::PipelineBarrier(
+      vk::PipelineStageFlagBits::eComputeShader,
+      vk::PipelineStageFlagBits::eDrawIndirect | vk::PipelineStageFlagBits::eComputeShader)
+      .Add(domainDispatch,
+           vk::AccessFlagBits::eShaderWrite,
+           vk::AccessFlagBits::eIndirectCommandRead | vk::AccessFlagBits::eShaderRead)
+      .Add(scalarDispatch,
+           vk::AccessFlagBits::eShaderWrite,
+           vk::AccessFlagBits::eIndirectCommandRead | vk::AccessFlagBits::eShaderRead)
+      .Add(iterations, vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead)
+      .Record(commandBuffer);
+}
+
 float ConjugateGradient::GetError()
 {
   mErrorRead.Submit().Wait();
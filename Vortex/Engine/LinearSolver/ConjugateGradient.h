@@ -44,33 +44,59 @@ public:
                                 Renderer::GenericBuffer& d,
                                 RigidBody& rigidBody) override;
   /**
-   * @brief Solve iteratively solve the linear equations in data
+   * @brief Solve iteratively solve the linear equations in data. With an
+   * iterative solver type and an error check interval bigger than one, the
+   * convergence is checked on the GPU after each iteration and the remaining
+   * iterations become no-ops. The error is only read back every interval.
+   * Warm starting is ignored with strongly coupled rigidbodies.
    */
   VORTEX_API void Solve(Parameters& params,
                         const std::vector<RigidBody*>& rigidbodies = {}) override;
 
+  VORTEX_API void RecordSolve(vk::CommandBuffer commandBuffer, unsigned iterations) override;
+
   VORTEX_API float GetError() override;
 
 private:
+  void SolveChecked(Parameters& params, const std::vector<RigidBody*>& rigidbodies);
+  void SubmitStart(const Parameters& params, const std::vector<RigidBody*>& rigidbodies);
+
+  void RecordStart(vk::CommandBuffer commandBuffer, bool warmStart);
+  void RecordInit(vk::CommandBuffer commandBuffer, bool checkConvergence);
+  void RecordStep(vk::CommandBuffer commandBuffer, bool checkConvergence);
+  void RecordConvergence(vk::CommandBuffer commandBuffer, int step);
+
   const Renderer::Device& mDevice;
   Preconditioner& mPreconditioner;
+  Renderer::GenericBuffer* mDiv;
+  Renderer::GenericBuffer* mPressure;
 
-  Renderer::Buffer<float> r, s, z, inner, alpha, beta, rho, rho_new, sigma;
+  Renderer::Buffer<float> r, s, z, alpha, beta, rho, rho_new, sigma;
   Renderer::Buffer<float> error, localError;
-  Renderer::Work matrixMultiply, scalarDivision, scalarMultiply, multiplyAdd, multiplySub;
-  ReduceSum reduceSum;
+  Renderer::Buffer<float> initialError, localInitialError;
+  Renderer::Buffer<glm::vec2> tolerance;
+  Renderer::Buffer<int> iterations, localIterations;
+  Renderer::IndirectBuffer<Renderer::DispatchParams> domainDispatch, scalarDispatch;
+  Renderer::Work matrixMultiply, scalarDivision, multiplyAdd, multiplySub, residual;
+  Renderer::Work convergence;
+  glm::ivec2 mWorkSize;
+  ReduceInner reduceInner;
   ReduceMax reduceMax;
 
   ReduceMax::Bound reduceMaxBound;
-  ReduceSum::Bound reduceSumRhoBound, reduceSumSigmaBound, reduceSumRhoNewBound;
-  Renderer::Work::Bound multiplySBound, multiplyZBound;
+  ReduceInner::Bound reduceRhoBound, reduceSigmaBound, reduceRhoNewBound;
   Renderer::Work::Bound matrixMultiplyBound;
   Renderer::Work::Bound divideRhoBound;
   Renderer::Work::Bound divideRhoNewBound;
   Renderer::Work::Bound multiplyAddPBound, multiplySubRBound, multiplyAddZBound;
+  Renderer::Work::Bound convergenceBound;
+  Renderer::Work::Bound residualBound;
+  WarmStart mWarmStart;
 
+  Renderer::CommandBuffer mSolveStart, mSolveWarmStart;
   Renderer::CommandBuffer mSolveInit, mSolve;
-  Renderer::CommandBuffer mErrorRead;
+  Renderer::CommandBuffer mSolveInitChecked, mSolveChecked;
+  Renderer::CommandBuffer mErrorRead, mInitRead, mConvergenceRead;
 };
 
 }  // namespace Fluid
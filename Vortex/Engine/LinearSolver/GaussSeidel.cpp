@@ -5,6 +5,7 @@
 
 #include "GaussSeidel.h"
 #include <cmath>
+#include <Vortex/Renderer/PipelineBarrier.h>
 #include <glm/gtc/constants.hpp>
 
 #include "vortex_generated_spirv.h"
@@ -85,6 +86,13 @@ void GaussSeidel::Solve(Parameters& params, const std::vector<RigidBody*>& /*rig
   }
 }
 
+void GaussSeidel::RecordSolve(vk::CommandBuffer commandBuffer, unsigned iterations)
+{
+  assert(mPressure != nullptr);
+  mPressure->Clear(commandBuffer);
+  Record(commandBuffer, static_cast<int>(iterations));
+}
+
 float GaussSeidel::GetError()
 {
   return mError.Submit().Wait().GetError();
@@ -102,12 +110,10 @@ void GaussSeidel::Record(vk::CommandBuffer commandBuffer, int iterations)
   {
     mGaussSeidelBound.PushConstant(commandBuffer, mW, 1);
     mGaussSeidelBound.Record(commandBuffer);
-    mPressure->Barrier(
-        commandBuffer, vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead);
+    Renderer::ComputeBarrier(commandBuffer, {*mPressure});
     mGaussSeidelBound.PushConstant(commandBuffer, mW, 0);
     mGaussSeidelBound.Record(commandBuffer);
-    mPressure->Barrier(
-        commandBuffer, vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead);
+    Renderer::ComputeBarrier(commandBuffer, {*mPressure});
   }
 }
 
@@ -116,6 +122,7 @@ Renderer::ComputeSize MakeLocalSize(const glm::ivec2& size)
   Renderer::ComputeSize computeSize(size);
   computeSize.WorkSize = glm::ivec2(1);
   computeSize.LocalSize = glm::ivec2(16);  // TODO shouldn't be hardcoded 16
+  computeSize.WorkShape = Renderer::ComputeSize::Shape::Fixed;
 
   return computeSize;
 }
@@ -140,8 +147,7 @@ void LocalGaussSeidel::Bind(Renderer::GenericBuffer& d,
 void LocalGaussSeidel::Record(vk::CommandBuffer commandBuffer)
 {
   mLocalGaussSeidelBound.Record(commandBuffer);
-  mPressure->Barrier(
-      commandBuffer, vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead);
+  Renderer::ComputeBarrier(commandBuffer, {*mPressure});
 }
 
 }  // namespace Fluid
@@ -39,6 +39,8 @@ public:
   VORTEX_API void Solve(Parameters& params,
                         const std::vector<RigidBody*>& rigidbodies = {}) override;
 
+  VORTEX_API void RecordSolve(vk::CommandBuffer commandBuffer, unsigned iterations) override;
+
   VORTEX_API float GetError() override;
 
   void Record(vk::CommandBuffer commandBuffer) override;
@@ -5,6 +5,7 @@
 
 #include "Jacobi.h"
 #include <cmath>
+#include <Vortex/Renderer/PipelineBarrier.h>
 #include <glm/gtc/constants.hpp>
 
 #include "vortex_generated_spirv.h"
@@ -55,12 +56,10 @@ void Jacobi::Record(vk::CommandBuffer commandBuffer, int iterations)
   {
     mJacobiFrontBound.PushConstant(commandBuffer, mW);
     mJacobiFrontBound.Record(commandBuffer);
-    mBackPressure.Barrier(
-        commandBuffer, vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead);
+    Renderer::ComputeBarrier(commandBuffer, {mBackPressure});
     mJacobiBackBound.PushConstant(commandBuffer, mW);
     mJacobiBackBound.Record(commandBuffer);
-    mPressure->Barrier(
-        commandBuffer, vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead);
+    Renderer::ComputeBarrier(commandBuffer, {*mPressure});
   }
 }
 
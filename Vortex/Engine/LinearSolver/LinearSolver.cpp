@@ -5,16 +5,24 @@
 
 #include "LinearSolver.h"
 
+#include <Vortex/Renderer/PipelineBarrier.h>
+
 #include "vortex_generated_spirv.h"
 
 namespace Vortex
 {
 namespace Fluid
 {
-LinearSolver::Parameters::Parameters(SolverType type, unsigned iterations, float errorTolerance)
+LinearSolver::Parameters::Parameters(SolverType type,
+                                     unsigned iterations,
+                                     float errorTolerance,
+                                     unsigned errorCheckInterval)
     : Type(type)
     , Iterations(iterations)
     , ErrorTolerance(errorTolerance)
+    , ErrorCheckInterval(errorCheckInterval)
+    , WarmStart(false)
+    , WarmStartScale(1.0f)
     , OutIterations(0)
     , OutError(0.0f)
 {
@@ -48,7 +56,8 @@ LinearSolver::DebugCopy::DebugCopy(const Renderer::Device& device,
                                    const glm::ivec2& size,
                                    LinearSolver::Data& data,
                                    LinearSolver::DebugData& debugData)
-    : mDebugDataCopy(device, size, SPIRV::DebugDataCopy_comp)
+    : mDevice(device)
+    , mDebugDataCopy(device, size, SPIRV::DebugDataCopy_comp)
     , mDebugDataCopyBound(mDebugDataCopy.Bind({data.Diagonal,
                                                data.Lower,
                                                data.X,
@@ -59,12 +68,7 @@ LinearSolver::DebugCopy::DebugCopy(const Renderer::Device& device,
                                                debugData.B}))
     , mCopy(device, false)
 {
-  mCopy.Record([&](vk::CommandBuffer commandBuffer) {
-    commandBuffer.debugMarkerBeginEXT({"Debug data copy", {{0.30f, 0.01f, 0.19f, 1.0f}}},
-                                      device.Loader());
-    mDebugDataCopyBound.Record(commandBuffer);
-    commandBuffer.debugMarkerEndEXT(device.Loader());
-  });
+  mCopy.Record([&](vk::CommandBuffer commandBuffer) { Copy(commandBuffer); });
 }
 
 void LinearSolver::DebugCopy::Copy()
@@ -72,6 +76,14 @@ void LinearSolver::DebugCopy::Copy()
   mCopy.Submit();
 }
 
+void LinearSolver::DebugCopy::Copy(vk::CommandBuffer commandBuffer)
+{
+  commandBuffer.debugMarkerBeginEXT({"Debug data copy", {{0.30f, 0.01f, 0.19f, 1.0f}}},
+                                    mDevice.Loader());
+  mDebugDataCopyBound.Record(commandBuffer);
+  commandBuffer.debugMarkerEndEXT(mDevice.Loader());
+}
+
 bool LinearSolver::Parameters::IsFinished(float initialError) const
 {
   if (Type == SolverType::Fixed)
@@ -100,10 +112,10 @@ LinearSolver::Parameters FixedParams(unsigned iterations)
   return LinearSolver::Parameters(LinearSolver::Parameters::SolverType::Fixed, iterations);
 }
 
-LinearSolver::Parameters IterativeParams(float errorTolerance)
+LinearSolver::Parameters IterativeParams(float errorTolerance, unsigned errorCheckInterval)
 {
   return LinearSolver::Parameters(
-      LinearSolver::Parameters::SolverType::Iterative, 1000, errorTolerance);
+      LinearSolver::Parameters::SolverType::Iterative, 1000, errorTolerance, errorCheckInterval);
 }
 
 LinearSolver::Error::Error(const Renderer::Device& device, const glm::ivec2& size)
@@ -157,5 +169,34 @@ float LinearSolver::Error::GetError()
   return error;
 }
 
+LinearSolver::WarmStart::WarmStart(const Renderer::Device& device, const glm::ivec2& size)
+    : mX(nullptr)
+    , mPrevious(device, size.x * size.y)
+    , mScale(device, 1, VMA_MEMORY_USAGE_CPU_ONLY)
+    , mWarmStartWork(device, size, SPIRV::WarmStart_comp)
+{
+  SetScale(1.0f);
+}
+
+void LinearSolver::WarmStart::Bind(Renderer::GenericBuffer& d, Renderer::GenericBuffer& x)
+{
+  mX = &x;
+  mWarmStartBound = mWarmStartWork.Bind({d, mPrevious, mScale, x});
+}
+
+void LinearSolver::WarmStart::SetScale(float scale)
+{
+  Renderer::CopyFrom(mScale, scale);
+}
+
+void LinearSolver::WarmStart::Record(vk::CommandBuffer commandBuffer)
+{
+  assert(mX != nullptr);
+
+  mPrevious.CopyFrom(commandBuffer, *mX);
+  mWarmStartBound.Record(commandBuffer);
+  Renderer::ComputeBarrier(commandBuffer, {*mX});
+}
+
 }  // namespace Fluid
 }  // namespace Vortex
@@ -43,8 +43,14 @@ struct LinearSolver
      * @param type fixed or iterative type of solver
      * @param iterations max number of iterations to perform
      * @param errorTolerance solver stops when the error is smaller than this.
+     * @param errorCheckInterval number of iterations between each read of the
+     * error. Solvers supporting it check the error on the GPU in between, the
+     * iterations after convergence only skip part of their work.
      */
-    VORTEX_API Parameters(SolverType type, unsigned iterations, float errorTolerance = 0.0f);
+    VORTEX_API Parameters(SolverType type,
+                          unsigned iterations,
+                          float errorTolerance = 0.0f,
+                          unsigned errorCheckInterval = 1);
 
     /**
      * @brief Checks if we've reacched the parameters.
@@ -61,6 +67,20 @@ struct LinearSolver
     SolverType Type;
     unsigned Iterations;
     float ErrorTolerance;
+    unsigned ErrorCheckInterval;
+
+    /**
+     * @brief Start from the current solution, e.g. the one of the previous
+     * step, instead of zero. Solvers fall back to zero when it cannot be used.
+     */
+    bool WarmStart;
+
+    /**
+     * @brief Scale of the current solution when warm starting, i.e. the ratio
+     * of the previous time step to the current one.
+     */
+    float WarmStartScale;
+
     unsigned OutIterations;
     float OutError;
   };
@@ -108,6 +128,13 @@ struct LinearSolver
      */
     VORTEX_API void Copy();
 
+    /**
+     * @brief Record the copy in a command buffer.
+     * @param commandBuffer command buffer to record into
+     */
+    VORTEX_API void Copy(vk::CommandBuffer commandBuffer);
+
+    const Renderer::Device& mDevice;
     Renderer::Work mDebugDataCopy;
     Renderer::Work::Bound mDebugDataCopyBound;
     Renderer::CommandBuffer mCopy;
@@ -142,6 +169,14 @@ struct LinearSolver
    */
   virtual void Solve(Parameters& params, const std::vector<RigidBody*>& rigidBodies = {}) = 0;
 
+  /**
+   * @brief Record a fixed number of iterations of the solver, so the solve can
+   * be part of a larger command buffer. Rigidbodies are not supported.
+   * @param commandBuffer command buffer to record into
+   * @param iterations number of iterations
+   */
+  virtual void RecordSolve(vk::CommandBuffer commandBuffer, unsigned iterations) = 0;
+
   /**
    * @return the max error
    */
@@ -197,6 +232,45 @@ struct LinearSolver
 
     Renderer::CommandBuffer mErrorCmd;
   };
+
+  /**
+   * Prepares the solution of the previous solve as the initial guess of the
+   * next one. The solution is scaled, cleared in cells which are not fluid
+   * anymore and extrapolated in cells which just became fluid.
+   */
+  class WarmStart
+  {
+  public:
+    VORTEX_API WarmStart(const Renderer::Device& device, const glm::ivec2& size);
+
+    /**
+     * @brief Bind the linear system.
+     * @param d the diagonal of the matrix
+     * @param x the unknowns, containing the previous solution
+     */
+    VORTEX_API void Bind(Renderer::GenericBuffer& d, Renderer::GenericBuffer& x);
+
+    /**
+     * @brief Set the scale of the previous solution. Must not be called while
+     * a recorded warm start is executing.
+     * @param scale ratio of the previous time step to the current one
+     */
+    VORTEX_API void SetScale(float scale);
+
+    /**
+     * @brief Record the preparation of the initial guess.
+     * @param commandBuffer the command buffer to record into.
+     */
+    VORTEX_API void Record(vk::CommandBuffer commandBuffer);
+
+  private:
+    Renderer::GenericBuffer* mX;
+    Renderer::Buffer<float> mPrevious;
+    Renderer::Buffer<float> mScale;
+
+    Renderer::Work mWarmStartWork;
+    Renderer::Work::Bound mWarmStartBound;
+  };
 };
 
 /**
@@ -210,9 +284,12 @@ VORTEX_API LinearSolver::Parameters FixedParams(unsigned iterations);
  * @brief Create a linear solver parameters object,
  * solver will continue until error tolerance is reached.
  * @param errorTolerance tolerance to reach before exiting
+ * @param errorCheckInterval number of iterations between each read of the
+ * error
  * @return parameters
  */
-VORTEX_API LinearSolver::Parameters IterativeParams(float errorTolerance);
+VORTEX_API LinearSolver::Parameters IterativeParams(float errorTolerance,
+                                                    unsigned errorCheckInterval = 1);
 
 }  // namespace Fluid
 }  // namespace Vortex
@@ -6,6 +6,7 @@
 #include "Multigrid.h"
 
 #include <Vortex/Engine/Pressure.h>
+#include <Vortex/Renderer/PipelineBarrier.h>
 
 #include "vortex_generated_spirv.h"
 
@@ -18,13 +19,12 @@ Depth::Depth(const glm::ivec2& size)
   auto s = size;
   mDepths.push_back(s);
 
+  // the coarsest level is solved by the local gauss-seidel, within one
+  // 16x16 group. Odd sizes are rounded up, the transfers skip the missing cells.
   const float min_size = 16.0f;
-  while (s.x > min_size && s.y > min_size)
+  while (s.x > min_size || s.y > min_size)
   {
-    if (s.x % 2 != 0 || s.y % 2 != 0)
-      throw std::runtime_error("Invalid multigrid size");
-
-    s = s / glm::ivec2(2);
+    s = (s + glm::ivec2(1)) / glm::ivec2(2);
     mDepths.push_back(s);
   }
 }
@@ -77,8 +77,12 @@ Multigrid::Multigrid(const Renderer::Device& device,
     , mResidualWork(device, size, SPIRV::Residual_comp)
     , mTransfer(device)
     , mPhiScaleWork(device, size, SPIRV::PhiScale_comp)
+    , mClearWork(device, Renderer::ComputeSize::Default1D(), SPIRV::Clear_comp)
     , mSmoother(device, mDepth.GetDepthSize(mDepth.GetMaxDepth()))
+    , mWarmStart(device, size)
     , mBuildHierarchies(device, false)
+    , mSolveStart(device, false)
+    , mSolveWarmStart(device)
     , mFullCycleSolver(device, false)
     , mVCycleSolver(device, false)
     , mError(device, size)
@@ -121,10 +125,13 @@ void Multigrid::Bind(Renderer::GenericBuffer& d,
   mTransfer.RestrictBind(0, s, mResiduals[0], d, mDatas[0].B, mDatas[0].Diagonal);
   mTransfer.ProlongateBind(0, s, pressure, d, mDatas[0].X, mDatas[0].Diagonal);
 
-  mFullCycleSolver.Record([&](vk::CommandBuffer commandBuffer) {
-    pressure.Clear(commandBuffer);
-    RecordFullCycle(commandBuffer);
-  });
+  mWarmStart.Bind(d, pressure);
+
+  mSolveStart.Record([&](vk::CommandBuffer commandBuffer) { pressure.Clear(commandBuffer); });
+  mSolveWarmStart.Record(
+      [&](vk::CommandBuffer commandBuffer) { mWarmStart.Record(commandBuffer); });
+  mFullCycleSolver.Record(
+      [&](vk::CommandBuffer commandBuffer) { RecordFullCycle(commandBuffer); });
 
   mVCycleSolver.Record([&](vk::CommandBuffer commandBuffer) { RecordVCycle(commandBuffer, 0); });
 
@@ -141,43 +148,56 @@ void Multigrid::BuildHierarchiesBind(Pressure& pressure,
 
   RecursiveBind(pressure, 1);
 
-  mBuildHierarchies.Record([&](vk::CommandBuffer commandBuffer) {
-    commandBuffer.debugMarkerBeginEXT({"Build hierarchies", {{0.36f, 0.85f, 0.55f, 1.0f}}},
-                                      mDevice.Loader());
-    for (int i = 0; i < mDepth.GetMaxDepth(); i++)
-    {
-      mLiquidPhiScaleWorkBound[i].Record(commandBuffer);
-      mLiquidPhis[i].Barrier(commandBuffer,
-                             vk::ImageLayout::eGeneral,
-                             vk::AccessFlagBits::eShaderWrite,
-                             vk::ImageLayout::eGeneral,
-                             vk::AccessFlagBits::eShaderRead);
-
-      mSolidPhiScaleWorkBound[i].Record(commandBuffer);
-      mSolidPhis[i].Barrier(commandBuffer,
-                            vk::ImageLayout::eGeneral,
-                            vk::AccessFlagBits::eShaderWrite,
-                            vk::ImageLayout::eGeneral,
-                            vk::AccessFlagBits::eShaderRead);
-
-      mMatrixBuildBound[i].PushConstant(commandBuffer, mDelta);
-      mMatrixBuildBound[i].Record(commandBuffer);
-      mDatas[i].Diagonal.Barrier(
-          commandBuffer, vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead);
-      mDatas[i].Lower.Barrier(
-          commandBuffer, vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead);
-      mDatas[i].B.Clear(commandBuffer);
-    }
-
-    int maxDepth = mDepth.GetMaxDepth();
-    mMatrixBuildBound[maxDepth - 1].PushConstant(commandBuffer, mDelta);
-    mMatrixBuildBound[maxDepth - 1].Record(commandBuffer);
-    mDatas[maxDepth - 1].Diagonal.Barrier(
-        commandBuffer, vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead);
-    mDatas[maxDepth - 1].Lower.Barrier(
-        commandBuffer, vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead);
-    commandBuffer.debugMarkerEndEXT(mDevice.Loader());
-  });
+  int maxDepth = mDepth.GetMaxDepth();
+  mBuildHierarchiesGraph.Clear();
+  for (int i = 0; i < maxDepth; i++)
+  {
+    Renderer::Texture& liquidInput = i == 0 ? liquidPhi : mLiquidPhis[i - 1];
+    Renderer::Texture& solidInput = i == 0 ? solidPhi : mSolidPhis[i - 1];
+
+    mBuildHierarchiesGraph.AddPass(
+        "Liquid phi scale " + std::to_string(i + 1),
+        {liquidInput},
+        {mLiquidPhis[i]},
+        [this, i](vk::CommandBuffer commandBuffer) {
+          mLiquidPhiScaleWorkBound[i].Record(commandBuffer);
+        });
+
+    mBuildHierarchiesGraph.AddPass(
+        "Solid phi scale " + std::to_string(i + 1),
+        {solidInput},
+        {mSolidPhis[i]},
+        [this, i](vk::CommandBuffer commandBuffer) {
+          mSolidPhiScaleWorkBound[i].Record(commandBuffer);
+        });
+  }
+
+  // mMatrixBuildBound[0] is the deepest level
+  mClearBBound.clear();
+  for (int i = 0; i < maxDepth; i++)
+  {
+    int depth = maxDepth - 1 - i;
+    auto depthSize = mDepth.GetDepthSize(depth + 1);
+    mClearBBound.push_back(mClearWork.Bind(depthSize.x * depthSize.y, {mDatas[depth].B}));
+
+    mBuildHierarchiesGraph.AddPass(
+        "Matrix build " + std::to_string(depth + 1),
+        {mLiquidPhis[depth], mSolidPhis[depth]},
+        {mDatas[depth].Diagonal, mDatas[depth].Lower},
+        [this, i](vk::CommandBuffer commandBuffer) {
+          mMatrixBuildBound[i].PushConstant(commandBuffer, mDelta);
+          mMatrixBuildBound[i].Record(commandBuffer);
+        });
+
+    mBuildHierarchiesGraph.AddPass(
+        "Clear B " + std::to_string(depth + 1),
+        {},
+        {mDatas[depth].B},
+        [this, i](vk::CommandBuffer commandBuffer) { mClearBBound[i].Record(commandBuffer); });
+  }
+
+  mBuildHierarchies.Record(
+      [&](vk::CommandBuffer commandBuffer) { BuildHierarchies(commandBuffer); });
 }
 
 void Multigrid::RecursiveBind(Pressure& pressure, std::size_t depth)
@@ -233,6 +253,14 @@ void Multigrid::BuildHierarchies()
   mBuildHierarchies.Submit();
 }
 
+void Multigrid::BuildHierarchies(vk::CommandBuffer commandBuffer)
+{
+  commandBuffer.debugMarkerBeginEXT({"Build hierarchies", {{0.36f, 0.85f, 0.55f, 1.0f}}},
+                                    mDevice.Loader());
+  mBuildHierarchiesGraph.Record(commandBuffer);
+  commandBuffer.debugMarkerEndEXT(mDevice.Loader());
+}
+
 void Multigrid::Smoother(vk::CommandBuffer commandBuffer, int n)
 {
   mSmoothers[n]->Record(commandBuffer);
@@ -261,6 +289,18 @@ void Multigrid::BindRigidbody(float /*delta*/, Renderer::GenericBuffer& /*d*/, R
 void Multigrid::Solve(Parameters& params, const std::vector<RigidBody*>& /*rigidBodies*/)
 {
   params.Reset();
+
+  if (params.WarmStart)
+  {
+    mSolveWarmStart.Wait();
+    mWarmStart.SetScale(params.WarmStartScale);
+    mSolveWarmStart.Submit();
+  }
+  else
+  {
+    mSolveStart.Submit();
+  }
+
   mFullCycleSolver.Submit();
   for (int i = 0; i < params.Iterations; i++)
   {
@@ -268,6 +308,17 @@ void Multigrid::Solve(Parameters& params, const std::vector<RigidBody*>& /*rigid
   }
 }
 
+void Multigrid::RecordSolve(vk::CommandBuffer commandBuffer, unsigned iterations)
+{
+  assert(mPressure != nullptr);
+  mPressure->Clear(commandBuffer);
+  RecordFullCycle(commandBuffer);
+  for (unsigned i = 0; i < iterations; i++)
+  {
+    RecordVCycle(commandBuffer, 0);
+  }
+}
+
 float Multigrid::GetError()
 {
   return mError.Submit().Wait().GetError();
@@ -284,8 +335,7 @@ void Multigrid::RecordVCycle(vk::CommandBuffer commandBuffer, int depth)
     Smoother(commandBuffer, depth);
 
     mResidualWorkBound[depth].Record(commandBuffer);
-    mResiduals[depth].Barrier(
-        commandBuffer, vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead);
+    Renderer::ComputeBarrier(commandBuffer, {mResiduals[depth]});
 
     mTransfer.Restrict(commandBuffer, depth);
 
@@ -302,8 +352,7 @@ void Multigrid::RecordVCycle(vk::CommandBuffer commandBuffer, int depth)
 void Multigrid::RecordFullCycle(vk::CommandBuffer commandBuffer)
 {
   mResidualWorkBound[0].Record(commandBuffer);
-  mResiduals[0].Barrier(
-      commandBuffer, vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead);
+  Renderer::ComputeBarrier(commandBuffer, {mResiduals[0]});
 
   for (int i = 0; i < mDepth.GetMaxDepth() - 1; i++)
   {
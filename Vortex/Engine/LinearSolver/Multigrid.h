@@ -12,6 +12,7 @@
 #include <Vortex/Engine/LinearSolver/Preconditioner.h>
 #include <Vortex/Engine/LinearSolver/Transfer.h>
 #include <Vortex/Renderer/CommandBuffer.h>
+#include <Vortex/Renderer/PassGraph.h>
 #include <Vortex/Renderer/Texture.h>
 #include <Vortex/Renderer/Timer.h>
 #include <Vortex/Renderer/Work.h>
@@ -21,7 +22,8 @@ namespace Vortex
 namespace Fluid
 {
 /**
- * @brief Contains the sizes of the multigrid hierarchy.
+ * @brief Contains the sizes of the multigrid hierarchy. Each level is half the
+ * size of the previous one, rounded up, until it is at most 16x16.
  */
 class Depth
 {
@@ -101,6 +103,12 @@ public:
    */
   VORTEX_API void BuildHierarchies();
 
+  /**
+   * @brief Record the computation of the hierarchy in a command buffer.
+   * @param commandBuffer command buffer to record into
+   */
+  VORTEX_API void BuildHierarchies(vk::CommandBuffer commandBuffer);
+
   void Record(vk::CommandBuffer commandBuffer) override;
 
   void BindRigidbody(float delta, Renderer::GenericBuffer& d, RigidBody& rigidBody) override;
@@ -113,6 +121,8 @@ public:
   VORTEX_API void Solve(Parameters& params,
                         const std::vector<RigidBody*>& rigidBodies = {}) override;
 
+  VORTEX_API void RecordSolve(vk::CommandBuffer commandBuffer, unsigned iterations) override;
+
   /**
    * @return the max error
    */
@@ -154,11 +164,18 @@ private:
 
   std::vector<Renderer::Work::Bound> mMatrixBuildBound;
 
+  Renderer::Work mClearWork;
+  std::vector<Renderer::Work::Bound> mClearBBound;
+
   // mSmoothers[0] is level 0
   std::vector<std::unique_ptr<Preconditioner>> mSmoothers;
   LocalGaussSeidel mSmoother;
 
+  WarmStart mWarmStart;
+
+  Renderer::PassGraph mBuildHierarchiesGraph;
   Renderer::CommandBuffer mBuildHierarchies;
+  Renderer::CommandBuffer mSolveStart, mSolveWarmStart;
   Renderer::CommandBuffer mFullCycleSolver, mVCycleSolver;
 
   LinearSolver::Error mError;
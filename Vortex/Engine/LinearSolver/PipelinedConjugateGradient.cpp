@@ -0,0 +1,255 @@
+//
+//  PipelinedConjugateGradient.cpp
+//  Vortex
+//
+
+#include "PipelinedConjugateGradient.h"
+
+#include <Vortex/Engine/Rigidbody.h>
+#include <Vortex/Renderer/PipelineBarrier.h>
+
+#include "vortex_generated_spirv.h"
+
+#include <algorithm>
+
+namespace Vortex
+{
+namespace Fluid
+{
+PipelinedConjugateGradient::PipelinedConjugateGradient(const Renderer::Device& device,
+                                                       const glm::ivec2& size,
+                                                       Preconditioner& preconditioner)
+    : mDevice(device)
+    , mPreconditioner(preconditioner)
+    , mDiv(nullptr)
+    , mPressure(nullptr)
+    , r(device, size.x * size.y)
+    , u(device, size.x * size.y)
+    , w(device, size.x * size.y)
+    , m(device, size.x * size.y)
+    , n(device, size.x * size.y)
+    , directions(device, size.x * size.y)
+    , state(device, 1)
+    , gamma(device, 1)
+    , delta(device, 1)
+    , error(device)
+    , localError(device, 1, VMA_MEMORY_USAGE_GPU_TO_CPU)
+    , initialError(device)
+    , localInitialError(device, 1, VMA_MEMORY_USAGE_GPU_TO_CPU)
+    , matrixMultiply(device, size, SPIRV::MultiplyMatrix_comp)
+    , scalars(device, glm::ivec2(1), SPIRV::PipelinedScalars_comp)
+    , update(device, size, SPIRV::PipelinedUpdate_comp)
+    , residual(device, size, SPIRV::Residual_comp)
+    , clear(device, Renderer::ComputeSize::Default1D(), SPIRV::Clear_comp)
+    , reduceInner(device, size)
+    , reduceMax(device, size)
+    , reduceDotsBound(reduceInner.Bind(u, r, w, gamma, delta, error))
+    , reduceMaxBound(reduceMax.Bind(r, error))
+    , reduceInitialErrorBound(reduceMax.Bind(r, initialError))
+    , scalarsBound(scalars.Bind({gamma, delta, state}))
+    , clearMBound(clear.Bind(size.x * size.y, {m}))
+    , mWarmStart(device, size)
+    , mSolveStart(device, false)
+    , mSolveWarmStart(device)
+    , mSolveInit(device, false)
+    , mSolve(device, false)
+    , mErrorRead(device)
+    , mInitRead(device)
+{
+  mErrorRead.Record(
+      [&](vk::CommandBuffer commandBuffer) { localError.CopyFrom(commandBuffer, error); });
+
+  mInitRead.Record([&](vk::CommandBuffer commandBuffer) {
+    localError.CopyFrom(commandBuffer, error);
+    localInitialError.CopyFrom(commandBuffer, initialError);
+  });
+}
+
+PipelinedConjugateGradient::~PipelinedConjugateGradient() {}
+
+void PipelinedConjugateGradient::Bind(Renderer::GenericBuffer& d,
+                                      Renderer::GenericBuffer& l,
+                                      Renderer::GenericBuffer& b,
+                                      Renderer::GenericBuffer& pressure)
+{
+  mPreconditioner.Bind(d, l, w, m);
+
+  matrixMultiplyBound = matrixMultiply.Bind({d, l, m, n});
+  matrixMultiplyInitBound = matrixMultiply.Bind({d, l, u, w});
+  updateBound = update.Bind({state, n, m, directions, pressure, r, u, w});
+  residualBound = residual.Bind({pressure, d, l, b, r});
+  mWarmStart.Bind(d, pressure);
+
+  mDiv = &b;
+  mPressure = &pressure;
+
+  // the dot products and the error are computed in a single fused reduction.
+  // It is recorded with its own barriers between levels, like the
+  // preconditioner, so the passes are not expected to overlap on the GPU.
+  mStepGraph.Clear();
+  mStepGraph.AddPass(
+      "Reduce", {r, u, w}, {gamma, delta, error}, [&](vk::CommandBuffer commandBuffer) {
+        reduceDotsBound.Record(commandBuffer);
+      });
+  mStepGraph.AddPass("Clear m", {}, {m}, [&](vk::CommandBuffer commandBuffer) {
+    clearMBound.Record(commandBuffer);
+  });
+  mStepGraph.AddPass("Preconditioner", {w}, {m}, [&](vk::CommandBuffer commandBuffer) {
+    mPreconditioner.Record(commandBuffer);
+  });
+  mStepGraph.AddPass("Matrix multiply", {m}, {n}, [&](vk::CommandBuffer commandBuffer) {
+    matrixMultiplyBound.Record(commandBuffer);
+  });
+  mStepGraph.AddPass(
+      "Scalars", {gamma, delta, state}, {state}, [&](vk::CommandBuffer commandBuffer) {
+        scalarsBound.Record(commandBuffer);
+      });
+  mStepGraph.AddPass("Update",
+                     {state, n, m, directions, pressure, r, u, w},
+                     {directions, pressure, r, u, w},
+                     [&](vk::CommandBuffer commandBuffer) { updateBound.Record(commandBuffer); });
+
+  mSolveStart.Record([&](vk::CommandBuffer commandBuffer) { RecordStart(commandBuffer, false); });
+  mSolveWarmStart.Record(
+      [&](vk::CommandBuffer commandBuffer) { RecordStart(commandBuffer, true); });
+  mSolveInit.Record([&](vk::CommandBuffer commandBuffer) { RecordInit(commandBuffer); });
+  mSolve.Record([&](vk::CommandBuffer commandBuffer) { RecordStep(commandBuffer); });
+}
+
+void PipelinedConjugateGradient::BindRigidbody(float /*delta*/,
+                                               Renderer::GenericBuffer& /*d*/,
+                                               RigidBody& rigidBody)
+{
+  if (rigidBody.GetType() == RigidBody::Type::eStrong)
+  {
+    throw std::runtime_error("Strong coupling not supported for pipelined conjugate gradient");
+  }
+}
+
+void PipelinedConjugateGradient::Solve(Parameters& params,
+                                       const std::vector<RigidBody*>& /*rigidbodies*/)
+{
+  params.Reset();
+
+  if (params.WarmStart)
+  {
+    mSolveWarmStart.Wait();
+    mWarmStart.SetScale(params.WarmStartScale);
+    mSolveWarmStart.Submit();
+  }
+  else
+  {
+    mSolveStart.Submit();
+  }
+
+  mSolveInit.Submit();
+
+  // the error is relative to the one of a zero initial guess, i.e. max(|b|)
+  float initialError = 0.0f;
+  if (params.Type == Parameters::SolverType::Iterative)
+  {
+    mInitRead.Submit().Wait();
+
+    Renderer::CopyTo(localError, params.OutError);
+    Renderer::CopyTo(localInitialError, initialError);
+    if (params.OutError <= params.ErrorTolerance)
+    {
+      return;
+    }
+  }
+
+  auto interval = std::max(params.ErrorCheckInterval, 1u);
+  for (unsigned i = 0; !params.IsFinished(initialError); params.OutIterations = ++i)
+  {
+    mSolve.Submit();
+
+    if (params.Type == Parameters::SolverType::Iterative && (i + 1) % interval == 0)
+    {
+      mErrorRead.Submit().Wait();
+      Renderer::CopyTo(localError, params.OutError);
+    }
+  }
+}
+
+void PipelinedConjugateGradient::RecordSolve(vk::CommandBuffer commandBuffer, unsigned iterations)
+{
+  RecordStart(commandBuffer, false);
+  RecordInit(commandBuffer);
+  for (unsigned i = 0; i < iterations; i++)
+  {
+    RecordStep(commandBuffer);
+  }
+}
+
+void PipelinedConjugateGradient::RecordStart(vk::CommandBuffer commandBuffer, bool warmStart)
+{
+  assert(mDiv != nullptr && mPressure != nullptr);
+
+  // r = b
+  r.CopyFrom(commandBuffer, *mDiv);
+
+  // calculate error of a zero initial guess
+  reduceInitialErrorBound.Record(commandBuffer);
+
+  if (warmStart)
+  {
+    // x = previous solution, r = b - Ax
+    mWarmStart.Record(commandBuffer);
+    residualBound.Record(commandBuffer);
+    Renderer::ComputeBarrier(commandBuffer, {r});
+  }
+  else
+  {
+    // x = 0
+    mPressure->Clear(commandBuffer);
+  }
+}
+
+void PipelinedConjugateGradient::RecordInit(vk::CommandBuffer commandBuffer)
+{
+  commandBuffer.debugMarkerBeginEXT({"Pipelined PCG Init", {{0.63f, 0.04f, 0.66f, 1.0f}}},
+                                    mDevice.Loader());
+
+  // calculate error
+  reduceMaxBound.Record(commandBuffer);
+
+  // u = M^-1 r
+  w.CopyFrom(commandBuffer, r);
+  m.Clear(commandBuffer);
+  mPreconditioner.Record(commandBuffer);
+  Renderer::ComputeBarrier(commandBuffer, {m});
+  u.CopyFrom(commandBuffer, m);
+
+  // w = Au
+  w.Clear(commandBuffer);
+  matrixMultiplyInitBound.Record(commandBuffer);
+  Renderer::ComputeBarrier(commandBuffer, {w});
+
+  // p = s = q = z = 0, alpha = beta = gamma = 0
+  directions.Clear(commandBuffer);
+  state.Clear(commandBuffer);
+
+  commandBuffer.debugMarkerEndEXT(mDevice.Loader());
+}
+
+void PipelinedConjugateGradient::RecordStep(vk::CommandBuffer commandBuffer)
+{
+  commandBuffer.debugMarkerBeginEXT({"Pipelined PCG Step", {{0.51f, 0.90f, 0.72f, 1.0f}}},
+                                    mDevice.Loader());
+
+  mStepGraph.Record(commandBuffer);
+
+  commandBuffer.debugMarkerEndEXT(mDevice.Loader());
+}
+
+float PipelinedConjugateGradient::GetError()
+{
+  mErrorRead.Submit().Wait();
+
+  float error;
+  Renderer::CopyTo(localError, error);
+  return error;
+}
+
+}  // namespace Fluid
+}  // namespace Vortex
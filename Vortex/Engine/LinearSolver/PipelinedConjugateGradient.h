@@ -0,0 +1,96 @@
+//
+//  PipelinedConjugateGradient.h
+//  Vortex
+//
+
+#pragma once
+
+#include <Vortex/Engine/LinearSolver/LinearSolver.h>
+#include <Vortex/Engine/LinearSolver/Preconditioner.h>
+#include <Vortex/Engine/LinearSolver/Reduce.h>
+#include <Vortex/Renderer/CommandBuffer.h>
+#include <Vortex/Renderer/PassGraph.h>
+#include <Vortex/Renderer/Work.h>
+
+namespace Vortex
+{
+namespace Fluid
+{
+/**
+ * @brief A pipelined preconditioned conjugate gradient linear solver. The dot
+ * products and the error of an iteration are combined in a single reduction,
+ * instead of the two reductions of @ref ConjugateGradient. The preconditioner
+ * can be specified.
+ *
+ * The error is the maximum residual before the last iteration. Strong
+ * rigidbody coupling is not supported.
+ */
+class PipelinedConjugateGradient : public LinearSolver
+{
+public:
+  /**
+   * @brief Initialize the solver with a size and preconditioner
+   * @param device vulkan device
+   * @param size
+   * @param preconditioner
+   */
+  VORTEX_API PipelinedConjugateGradient(const Renderer::Device& device,
+                                        const glm::ivec2& size,
+                                        Preconditioner& preconditioner);
+
+  VORTEX_API ~PipelinedConjugateGradient() override;
+
+  VORTEX_API void Bind(Renderer::GenericBuffer& d,
+                       Renderer::GenericBuffer& l,
+                       Renderer::GenericBuffer& b,
+                       Renderer::GenericBuffer& pressure) override;
+
+  VORTEX_API void BindRigidbody(float delta,
+                                Renderer::GenericBuffer& d,
+                                RigidBody& rigidBody) override;
+
+  /**
+   * @brief Solve iteratively solve the linear equations in data. With an
+   * iterative solver type, the error is read back every error check interval.
+   */
+  VORTEX_API void Solve(Parameters& params,
+                        const std::vector<RigidBody*>& rigidbodies = {}) override;
+
+  VORTEX_API void RecordSolve(vk::CommandBuffer commandBuffer, unsigned iterations) override;
+
+  VORTEX_API float GetError() override;
+
+private:
+  void RecordStart(vk::CommandBuffer commandBuffer, bool warmStart);
+  void RecordInit(vk::CommandBuffer commandBuffer);
+  void RecordStep(vk::CommandBuffer commandBuffer);
+
+  const Renderer::Device& mDevice;
+  Preconditioner& mPreconditioner;
+  Renderer::GenericBuffer* mDiv;
+  Renderer::GenericBuffer* mPressure;
+
+  Renderer::Buffer<float> r, u, w, m, n;
+  Renderer::Buffer<glm::vec4> directions, state;
+  Renderer::Buffer<float> gamma, delta, error, localError;
+  Renderer::Buffer<float> initialError, localInitialError;
+  Renderer::Work matrixMultiply, scalars, update, residual, clear;
+  ReduceInner reduceInner;
+  ReduceMax reduceMax;
+
+  ReduceInner::Bound reduceDotsBound;
+  ReduceMax::Bound reduceMaxBound, reduceInitialErrorBound;
+  Renderer::Work::Bound scalarsBound, clearMBound;
+  Renderer::Work::Bound matrixMultiplyBound, matrixMultiplyInitBound;
+  Renderer::Work::Bound updateBound;
+  Renderer::Work::Bound residualBound;
+  WarmStart mWarmStart;
+
+  Renderer::PassGraph mStepGraph;
+  Renderer::CommandBuffer mSolveStart, mSolveWarmStart;
+  Renderer::CommandBuffer mSolveInit, mSolve;
+  Renderer::CommandBuffer mErrorRead, mInitRead;
+};
+
+}  // namespace Fluid
+}  // namespace Vortex
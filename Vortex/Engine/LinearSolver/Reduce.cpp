@@ -6,9 +6,11 @@
 #include "Reduce.h"
 
 #include <Vortex/Renderer/DescriptorSet.h>
+#include <Vortex/Renderer/PipelineBarrier.h>
 #include <Vortex/Renderer/Work.h>
 
 #include "vortex_generated_spirv.h"
+#include "vortex_generated_subgroup_spirv.h"
 
 namespace Vortex
 {
@@ -68,10 +70,20 @@ Reduce::Bound Reduce::Bind(Renderer::GenericBuffer& input, Renderer::GenericBuff
     bounds.emplace_back(mReduce.Bind(computeSize, {*buffers[i], *buffers[i + 1]}));
     computeSize = MakeComputeSize(computeSize.WorkSize.x);
 
+    // intermediate results are only read by the next reduce dispatch, the final
+    // output can be read by any following command.
+    vk::PipelineStageFlags dstStage = i + 2 < buffers.size()
+                                          ? vk::PipelineStageFlagBits::eComputeShader
+                                          : vk::PipelineStageFlagBits::eAllCommands;
+
     vk::Buffer buffer = buffers[i + 1]->Handle();
     bufferBarriers.emplace_back([=](vk::CommandBuffer commandBuffer) {
-      Renderer::BufferBarrier(
-          buffer, commandBuffer, vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead);
+      Renderer::BufferBarrier(buffer,
+                              commandBuffer,
+                              vk::PipelineStageFlagBits::eComputeShader,
+                              vk::AccessFlagBits::eShaderWrite,
+                              dstStage,
+                              vk::AccessFlagBits::eShaderRead);
     });
   }
 
@@ -121,5 +133,131 @@ ReduceMax::ReduceMax(const Renderer::Device& device, const glm::ivec2& size)
 {
 }
 
+ReduceInner::ReduceInner(const Renderer::Device& device, const glm::ivec2& size)
+    : mSize(size.x * size.y)
+    , mInner(device,
+             Renderer::ComputeSize::Default1D(),
+             device.HasSubgroupArithmetic() ? SPIRV::InnerSubgroup_comp : SPIRV::Inner_comp)
+    , mInnerReduce(device,
+                   Renderer::ComputeSize::Default1D(),
+                   device.HasSubgroupArithmetic() ? SPIRV::InnerReduceSubgroup_comp
+                                                  : SPIRV::InnerReduce_comp)
+{
+  auto computeSize = MakeComputeSize(mSize);
+  while (computeSize.WorkSize.x > 1)
+  {
+    mBuffers.emplace_back(device,
+                          vk::BufferUsageFlagBits::eStorageBuffer,
+                          VMA_MEMORY_USAGE_GPU_ONLY,
+                          sizeof(glm::vec4) * computeSize.WorkSize.x);
+
+    computeSize = MakeComputeSize(computeSize.WorkSize.x);
+  }
+
+  assert(computeSize.WorkSize.x == 1);
+}
+
+ReduceInner::Bound ReduceInner::Bind(Renderer::GenericBuffer& a,
+                                     Renderer::GenericBuffer& b,
+                                     Renderer::GenericBuffer& dot)
+{
+  return Bind(a, b, b, dot, dot, dot, 1, 0);
+}
+
+ReduceInner::Bound ReduceInner::Bind(Renderer::GenericBuffer& a,
+                                     Renderer::GenericBuffer& b,
+                                     Renderer::GenericBuffer& dot,
+                                     Renderer::GenericBuffer& max)
+{
+  return Bind(a, b, b, dot, dot, max, 1, 1);
+}
+
+ReduceInner::Bound ReduceInner::Bind(Renderer::GenericBuffer& a,
+                                     Renderer::GenericBuffer& b,
+                                     Renderer::GenericBuffer& c,
+                                     Renderer::GenericBuffer& dot0,
+                                     Renderer::GenericBuffer& dot1,
+                                     Renderer::GenericBuffer& max)
+{
+  return Bind(a, b, c, dot0, dot1, max, 2, 1);
+}
+
+ReduceInner::Bound ReduceInner::Bind(Renderer::GenericBuffer& a,
+                                     Renderer::GenericBuffer& b,
+                                     Renderer::GenericBuffer& c,
+                                     Renderer::GenericBuffer& dot0,
+                                     Renderer::GenericBuffer& dot1,
+                                     Renderer::GenericBuffer& max,
+                                     int dots,
+                                     int maxAbs)
+{
+  // the outputs are only written by the last level, which has a single work
+  // group. The unused outputs are never written.
+  std::vector<Renderer::GenericBuffer*> buffers;
+  for (auto& buffer : mBuffers)
+  {
+    buffers.push_back(&buffer);
+  }
+  buffers.push_back(&dot0);
+
+  std::vector<Renderer::CommandBuffer::CommandFn> bufferBarriers;
+  std::vector<Renderer::Work::Bound> bounds;
+
+  auto computeSize = MakeComputeSize(mSize);
+  bounds.emplace_back(mInner.Bind(computeSize, {a, b, c, *buffers[0], dot0, dot1, max}));
+  for (std::size_t i = 0; i < mBuffers.size(); i++)
+  {
+    computeSize = MakeComputeSize(computeSize.WorkSize.x);
+    bounds.emplace_back(
+        mInnerReduce.Bind(computeSize, {*buffers[i], *buffers[i + 1], dot0, dot1, max}));
+
+    vk::Buffer buffer = buffers[i]->Handle();
+    bufferBarriers.emplace_back([=](vk::CommandBuffer commandBuffer) {
+      Renderer::BufferBarrier(buffer,
+                              commandBuffer,
+                              vk::PipelineStageFlagBits::eComputeShader,
+                              vk::AccessFlagBits::eShaderWrite,
+                              vk::PipelineStageFlagBits::eComputeShader,
+                              vk::AccessFlagBits::eShaderRead);
+    });
+  }
+
+  // the final outputs can be read by any following command.
+  Renderer::PipelineBarrier outputBarrier(vk::PipelineStageFlagBits::eComputeShader,
+                                          vk::PipelineStageFlagBits::eAllCommands);
+  outputBarrier.Add(dot0, vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead);
+  if (dots > 1)
+  {
+    outputBarrier.Add(dot1, vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead);
+  }
+  if (maxAbs != 0)
+  {
+    outputBarrier.Add(max, vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead);
+  }
+
+  bufferBarriers.emplace_back(
+      [=](vk::CommandBuffer commandBuffer) { outputBarrier.Record(commandBuffer); });
+
+  return Bound(dots, maxAbs, bufferBarriers, std::move(bounds));
+}
+
+ReduceInner::Bound::Bound(int dots,
+                          int maxAbs,
+                          const std::vector<Renderer::CommandBuffer::CommandFn>& bufferBarriers,
+                          std::vector<Renderer::Work::Bound>&& bounds)
+    : mDots(dots), mMaxAbs(maxAbs), mBufferBarriers(bufferBarriers), mBounds(std::move(bounds))
+{
+}
+
+void ReduceInner::Bound::Record(vk::CommandBuffer commandBuffer)
+{
+  for (std::size_t i = 0; i < mBounds.size(); i++)
+  {
+    mBounds[i].PushConstant(commandBuffer, mDots, mMaxAbs);
+    mBounds[i].Record(commandBuffer);
+    mBufferBarriers[i](commandBuffer);
+  }
+}
+
 }  // namespace Fluid
 }  // namespace Vortex
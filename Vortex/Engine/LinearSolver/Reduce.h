@@ -110,5 +110,108 @@ public:
   VORTEX_API ReduceMax(const Renderer::Device& device, const glm::ivec2& size);
 };
 
+/**
+ * @brief Fused parallel reduction of the dot products of a vector with one or
+ * two other vectors, and of the max of absolute of the first of those. The
+ * products are computed while reducing, without a temporary buffer. Subgroup
+ * operations are used when supported by the device.
+ */
+class ReduceInner
+{
+public:
+  /**
+   * @brief Bound input and output buffers for a fused reduce operation.
+   */
+  class Bound
+  {
+  public:
+    Bound() = default;
+
+    /**
+     * @brief Record the reduce operation.
+     * @param commandBuffer the command buffer to record into.
+     */
+    VORTEX_API void Record(vk::CommandBuffer commandBuffer);
+
+    friend class ReduceInner;
+
+  private:
+    Bound(int dots,
+          int maxAbs,
+          const std::vector<Renderer::CommandBuffer::CommandFn>& bufferBarriers,
+          std::vector<Renderer::Work::Bound>&& bounds);
+
+    int mDots;
+    int mMaxAbs;
+    std::vector<Renderer::CommandBuffer::CommandFn> mBufferBarriers;
+    std::vector<Renderer::Work::Bound> mBounds;
+  };
+
+  /**
+   * @brief Initialize reduce with device and 2d size
+   * @param device
+   * @param size
+   */
+  VORTEX_API ReduceInner(const Renderer::Device& device, const glm::ivec2& size);
+
+  /**
+   * @brief Bind the reduce operation dot = (a, b)
+   * @param a first vector
+   * @param b second vector
+   * @param dot output of the dot product
+   * @return a bound object that can be recorded in a command buffer.
+   */
+  VORTEX_API Bound Bind(Renderer::GenericBuffer& a,
+                        Renderer::GenericBuffer& b,
+                        Renderer::GenericBuffer& dot);
+
+  /**
+   * @brief Bind the reduce operation dot = (a, b) and max = max(|b|)
+   * @param a first vector
+   * @param b second vector
+   * @param dot output of the dot product
+   * @param max output of the max of absolute of b
+   * @return a bound object that can be recorded in a command buffer.
+   */
+  VORTEX_API Bound Bind(Renderer::GenericBuffer& a,
+                        Renderer::GenericBuffer& b,
+                        Renderer::GenericBuffer& dot,
+                        Renderer::GenericBuffer& max);
+
+  /**
+   * @brief Bind the reduce operation dot0 = (a, b), dot1 = (a, c) and max =
+   * max(|b|)
+   * @param a first vector
+   * @param b second vector
+   * @param c third vector
+   * @param dot0 output of the dot product of a and b
+   * @param dot1 output of the dot product of a and c
+   * @param max output of the max of absolute of b
+   * @return a bound object that can be recorded in a command buffer.
+   */
+  VORTEX_API Bound Bind(Renderer::GenericBuffer& a,
+                        Renderer::GenericBuffer& b,
+                        Renderer::GenericBuffer& c,
+                        Renderer::GenericBuffer& dot0,
+                        Renderer::GenericBuffer& dot1,
+                        Renderer::GenericBuffer& max);
+
+private:
+  Bound Bind(Renderer::GenericBuffer& a,
+             Renderer::GenericBuffer& b,
+             Renderer::GenericBuffer& c,
+             Renderer::GenericBuffer& dot0,
+             Renderer::GenericBuffer& dot1,
+             Renderer::GenericBuffer& max,
+             int dots,
+             int maxAbs);
+
+  int mSize;
+  Renderer::Work mInner;
+  Renderer::Work mInnerReduce;
+  std::vector<Renderer::GenericBuffer> mBuffers;
+};
+
+
 }  // namespace Fluid
 }  // namespace Vortex
@@ -5,6 +5,8 @@
 
 #include "Transfer.h"
 
+#include <Vortex/Renderer/PipelineBarrier.h>
+
 #include "vortex_generated_spirv.h"
 
 namespace Vortex
@@ -47,13 +49,15 @@ void Transfer::RestrictBind(std::size_t level,
   {
     mRestrictBound.resize(level + 1);
     mRestrictBuffer.resize(level + 1);
+    mRestrictFineSize.resize(level + 1);
   }
 
-  glm::ivec2 coarseSize = fineSize / glm::ivec2(2);
+  glm::ivec2 coarseSize = (fineSize + glm::ivec2(1)) / glm::ivec2(2);
 
   mRestrictBound[level] =
       mRestrictWork.Bind(coarseSize, {fineDiagonal, fine, coarseDiagonal, coarse});
   mRestrictBuffer[level] = &coarse;
+  mRestrictFineSize[level] = fineSize;
 }
 
 void Transfer::Prolongate(vk::CommandBuffer commandBuffer, std::size_t level)
@@ -61,17 +65,17 @@ void Transfer::Prolongate(vk::CommandBuffer commandBuffer, std::size_t level)
   assert(level < mProlongateBound.size());
 
   mProlongateBound[level].Record(commandBuffer);
-  mProlongateBuffer[level]->Barrier(
-      commandBuffer, vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead);
+  Renderer::ComputeBarrier(commandBuffer, {*mProlongateBuffer[level]});
 }
 
 void Transfer::Restrict(vk::CommandBuffer commandBuffer, std::size_t level)
 {
   assert(level < mRestrictBound.size());
 
+  auto& fineSize = mRestrictFineSize[level];
+  mRestrictBound[level].PushConstant(commandBuffer, fineSize.x, fineSize.y);
   mRestrictBound[level].Record(commandBuffer);
-  mRestrictBuffer[level]->Barrier(
-      commandBuffer, vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead);
+  Renderer::ComputeBarrier(commandBuffer, {*mRestrictBuffer[level]});
 }
 
 }  // namespace Fluid
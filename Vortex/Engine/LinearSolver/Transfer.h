@@ -27,7 +27,7 @@ public:
   /**
    * @brief Prolongate a level set on a finer level set. Setting the 4 cells to
    * the value of the coarser grid. Multiple level sets can be bound and
-   * indexed.
+   * indexed. The sizes don't need to be even, the coarse size is rounded up.
    * @param level the index of the bound level set to prolongate
    * @param fineSize size of the finer level set
    * @param fine the finer level set
@@ -35,7 +35,7 @@ public:
    * fineSize
    * @param coarse the coarse level set
    * @param coarseDiagonal the diagonal of the linear equation matrix at size
-   * half of @p fineSize
+   * half of @p fineSize, rounded up
    */
   VORTEX_API void ProlongateBind(std::size_t level,
                                  const glm::ivec2& fineSize,
@@ -46,7 +46,8 @@ public:
 
   /**
    * @brief Restricing the level set on a coarser level set. Averages 4 cells
-   * into one. Multiple level sets can be bound and indexed.
+   * into one, or less on the last row and column of odd sizes. Multiple level
+   * sets can be bound and indexed.
    * @param level the index of the bound level set to prolongate
    * @param fineSize size of the finer level set
    * @param fine the finer level set
@@ -54,7 +55,7 @@ public:
    * fineSize
    * @param coarse the coarse level set
    * @param coarseDiagonal the diagonal of the linear equation matrix at size
-   * half of @p fineSize
+   * half of @p fineSize, rounded up
    */
   VORTEX_API void RestrictBind(std::size_t level,
                                const glm::ivec2& fineSize,
@@ -88,6 +89,7 @@ private:
   Renderer::Work mRestrictWork;
   std::vector<Renderer::Work::Bound> mRestrictBound;
   std::vector<Renderer::GenericBuffer*> mRestrictBuffer;
+  std::vector<glm::ivec2> mRestrictFineSize;
 };
 
 }  // namespace Fluid
@@ -7,6 +7,7 @@
 
 #include <Vortex/Engine/LevelSet.h>
 
+#include <algorithm>
 #include <random>
 #include "vortex_generated_spirv.h"
 
@@ -30,11 +31,15 @@ ParticleCount::ParticleCount(const Renderer::Device& device,
     , mDevice(device)
     , mSize(size)
     , mParticles(particles)
+    , mLevelSet(nullptr)
+    , mValid(nullptr)
     , mNewParticles(device, 8 * size.x * size.y)
     , mDelta(device, size.x * size.y)
     , mCount(device, size.x * size.y)
     , mIndex(device, size.x * size.y)
     , mSeeds(device, 4, VMA_MEMORY_USAGE_CPU_TO_GPU)
+    , mJumpFloodSeeds(device, size.x * size.y)
+    , mNewJumpFloodSeeds(device, size.x * size.y)
     , mDispatchParams(device)
     , mLocalDispatchParams(device, 1, VMA_MEMORY_USAGE_CPU_ONLY)
     , mNewDispatchParams(device)
@@ -54,6 +59,16 @@ ParticleCount::ParticleCount(const Renderer::Device& device,
                        size,
                        SPIRV::ParticlePhi_comp,
                        Renderer::SpecConst(Renderer::SpecConstValue(3, particleSize)))
+    , mJumpFloodInitWork(device, size, SPIRV::JumpFloodInit_comp)
+    , mJumpFloodInitBound(
+          mJumpFloodInitWork.Bind({mCount, mParticles, mIndex, mJumpFloodSeeds}))
+    , mJumpFloodWork(device, size, SPIRV::JumpFlood_comp)
+    , mJumpFloodBound(mJumpFloodWork.Bind({mParticles, mJumpFloodSeeds, mNewJumpFloodSeeds}))
+    , mNewJumpFloodBound(mJumpFloodWork.Bind({mParticles, mNewJumpFloodSeeds, mJumpFloodSeeds}))
+    , mJumpFloodPhiWork(device,
+                        size,
+                        SPIRV::JumpFloodPhi_comp,
+                        Renderer::SpecConst(Renderer::SpecConstValue(3, particleSize)))
     , mParticleToGridWork(device, size, SPIRV::ParticleToGrid_comp)
     , mParticleFromGridWork(device,
                             Renderer::ComputeSize::Default1D(),
@@ -64,6 +79,7 @@ ParticleCount::ParticleCount(const Renderer::Device& device,
     , mParticlePhi(device, false)
     , mParticleToGrid(device, false)
     , mParticleFromGrid(device, false)
+    , mPhiMethod(PhiMethod::Kernel)
     , mAlpha(alpha)
 {
   Renderer::CopyFrom(mLocalDispatchParams, params);
@@ -92,33 +108,7 @@ ParticleCount::ParticleCount(const Renderer::Device& device,
   //    -> set the new particles with random position
   // 8) copy new particles to particles
 
-  mScanWork.Record([&](vk::CommandBuffer commandBuffer) {
-    commandBuffer.debugMarkerBeginEXT({"Particle count", {{0.14f, 0.39f, 0.12f, 1.0f}}},
-                                      mDevice.Loader());
-    mDelta.CopyFrom(commandBuffer, *this);
-    Clear(commandBuffer, std::array<int, 4>{0, 0, 0, 0});
-    mParticleCountBound.RecordIndirect(commandBuffer, mDispatchParams);
-    mDelta.Barrier(
-        commandBuffer, vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead);
-    mParticleClampBound.Record(commandBuffer);
-    mDelta.Barrier(
-        commandBuffer, vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead);
-    mCount.CopyFrom(commandBuffer, mDelta);
-    commandBuffer.debugMarkerEndEXT(mDevice.Loader());
-
-    commandBuffer.debugMarkerBeginEXT({"Particle scan", {{0.59f, 0.20f, 0.35f, 1.0f}}},
-                                      mDevice.Loader());
-    mPrefixScanBound.Record(commandBuffer);
-    mParticleBucketBound.RecordIndirect(commandBuffer, mDispatchParams);
-    mNewParticles.Barrier(
-        commandBuffer, vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead);
-    mParticleSpawnBound.Record(commandBuffer);
-    mNewParticles.Barrier(
-        commandBuffer, vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead);
-    particles.CopyFrom(commandBuffer, mNewParticles);
-    mDispatchParams.CopyFrom(commandBuffer, mNewDispatchParams);
-    commandBuffer.debugMarkerEndEXT(mDevice.Loader());
-  });
+  mScanWork.Record([&](vk::CommandBuffer commandBuffer) { Scan(commandBuffer); });
 
   mDispatchCountWork.Record([&](vk::CommandBuffer commandBuffer) {
     mLocalDispatchParams.CopyFrom(commandBuffer, mDispatchParams);
@@ -126,6 +116,39 @@ ParticleCount::ParticleCount(const Renderer::Device& device,
 }
 
 void ParticleCount::Scan()
+{
+  GenerateSeeds();
+  mScanWork.Submit();
+}
+
+void ParticleCount::Scan(vk::CommandBuffer commandBuffer)
+{
+  commandBuffer.debugMarkerBeginEXT({"Particle count", {{0.14f, 0.39f, 0.12f, 1.0f}}},
+                                    mDevice.Loader());
+  mDelta.CopyFrom(commandBuffer, *this);
+  Clear(commandBuffer, std::array<int, 4>{0, 0, 0, 0});
+  mParticleCountBound.RecordIndirect(commandBuffer, mDispatchParams);
+  mDelta.Barrier(commandBuffer, vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead);
+  mParticleClampBound.Record(commandBuffer);
+  mDelta.Barrier(commandBuffer, vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead);
+  mCount.CopyFrom(commandBuffer, mDelta);
+  commandBuffer.debugMarkerEndEXT(mDevice.Loader());
+
+  commandBuffer.debugMarkerBeginEXT({"Particle scan", {{0.59f, 0.20f, 0.35f, 1.0f}}},
+                                    mDevice.Loader());
+  mPrefixScanBound.Record(commandBuffer);
+  mParticleBucketBound.RecordIndirect(commandBuffer, mDispatchParams);
+  mNewParticles.Barrier(
+      commandBuffer, vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead);
+  mParticleSpawnBound.Record(commandBuffer);
+  mNewParticles.Barrier(
+      commandBuffer, vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead);
+  mParticles.CopyFrom(commandBuffer, mNewParticles);
+  mDispatchParams.CopyFrom(commandBuffer, mNewDispatchParams);
+  commandBuffer.debugMarkerEndEXT(mDevice.Loader());
+}
+
+void ParticleCount::GenerateSeeds()
 {
   std::random_device rd;
   std::mt19937 gen(rd());
@@ -135,7 +158,6 @@ void ParticleCount::Scan()
       {dis(gen), dis(gen)}, {dis(gen), dis(gen)}, {dis(gen), dis(gen)}, {dis(gen), dis(gen)}};
 
   Renderer::CopyFrom(mSeeds, seeds);
-  mScanWork.Submit();
 }
 
 int ParticleCount::GetTotalCount()
@@ -152,22 +174,15 @@ Renderer::IndirectBuffer<Renderer::DispatchParams>& ParticleCount::GetDispatchPa
   return mDispatchParams;
 }
 
-void ParticleCount::LevelSetBind(LevelSet& levelSet)
+void ParticleCount::LevelSetBind(LevelSet& levelSet, PhiMethod method)
 {
   // TODO should shrink wrap wholes and redistance
+  mLevelSet = &levelSet;
+  mPhiMethod = method;
   mParticlePhiBound = mParticlePhiWork.Bind({mCount, mParticles, mIndex, levelSet});
-  mParticlePhi.Record([&](vk::CommandBuffer commandBuffer) {
-    commandBuffer.debugMarkerBeginEXT({"Particle phi", {{0.86f, 0.72f, 0.29f, 1.0f}}},
-                                      mDevice.Loader());
-    levelSet.Clear(commandBuffer, std::array<float, 4>{3.0f, 0.0f, 0.0f, 0.0f});
-    mParticlePhiBound.Record(commandBuffer);
-    levelSet.Barrier(commandBuffer,
-                     vk::ImageLayout::eGeneral,
-                     vk::AccessFlagBits::eShaderWrite,
-                     vk::ImageLayout::eGeneral,
-                     vk::AccessFlagBits::eShaderRead);
-    commandBuffer.debugMarkerEndEXT(mDevice.Loader());
-  });
+  mJumpFloodPhiBound = mJumpFloodPhiWork.Bind({mParticles, mJumpFloodSeeds, levelSet});
+  mNewJumpFloodPhiBound = mJumpFloodPhiWork.Bind({mParticles, mNewJumpFloodSeeds, levelSet});
+  mParticlePhi.Record([&](vk::CommandBuffer commandBuffer) { Phi(commandBuffer); });
 }
 
 void ParticleCount::Phi()
@@ -177,27 +192,14 @@ void ParticleCount::Phi()
 
 void ParticleCount::VelocitiesBind(Velocity& velocity, Renderer::GenericBuffer& valid)
 {
+  mValid = &valid;
   mParticleToGridBound = mParticleToGridWork.Bind({mCount, mParticles, mIndex, velocity, valid});
-  mParticleToGrid.Record([&](vk::CommandBuffer commandBuffer) {
-    commandBuffer.debugMarkerBeginEXT({"Particle to grid", {{0.71f, 0.15f, 0.48f, 1.0f}}},
-                                      mDevice.Loader());
-    valid.Clear(commandBuffer);
-    mParticleToGridBound.Record(commandBuffer);
-    valid.Barrier(commandBuffer, vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead);
-    commandBuffer.debugMarkerEndEXT(mDevice.Loader());
-  });
+  mParticleToGrid.Record([&](vk::CommandBuffer commandBuffer) { TransferToGrid(commandBuffer); });
 
   mParticleFromGridBound =
       mParticleFromGridWork.Bind({mParticles, mDispatchParams, velocity, velocity.D()});
-  mParticleFromGrid.Record([&](vk::CommandBuffer commandBuffer) {
-    commandBuffer.debugMarkerBeginEXT({"Particle from grid", {{0.35f, 0.11f, 0.87f, 1.0f}}},
-                                      mDevice.Loader());
-    mParticleFromGridBound.PushConstant(commandBuffer, mSize.x, mSize.y, mAlpha);
-    mParticleFromGridBound.RecordIndirect(commandBuffer, mDispatchParams);
-    mParticles.Barrier(
-        commandBuffer, vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead);
-    commandBuffer.debugMarkerEndEXT(mDevice.Loader());
-  });
+  mParticleFromGrid.Record(
+      [&](vk::CommandBuffer commandBuffer) { TransferFromGrid(commandBuffer); });
 }
 
 void ParticleCount::TransferToGrid()
@@ -210,5 +212,84 @@ void ParticleCount::TransferFromGrid()
   mParticleFromGrid.Submit();
 }
 
+void ParticleCount::Phi(vk::CommandBuffer commandBuffer)
+{
+  assert(mLevelSet != nullptr);
+
+  commandBuffer.debugMarkerBeginEXT({"Particle phi", {{0.86f, 0.72f, 0.29f, 1.0f}}},
+                                    mDevice.Loader());
+  if (mPhiMethod == PhiMethod::JumpFlood)
+  {
+    RecordJumpFlood(commandBuffer);
+  }
+  else
+  {
+    mLevelSet->Clear(commandBuffer, std::array<float, 4>{3.0f, 0.0f, 0.0f, 0.0f});
+    mParticlePhiBound.Record(commandBuffer);
+  }
+  mLevelSet->Barrier(commandBuffer,
+                     vk::ImageLayout::eGeneral,
+                     vk::AccessFlagBits::eShaderWrite,
+                     vk::ImageLayout::eGeneral,
+                     vk::AccessFlagBits::eShaderRead);
+  commandBuffer.debugMarkerEndEXT(mDevice.Loader());
+}
+
+void ParticleCount::RecordJumpFlood(vk::CommandBuffer commandBuffer)
+{
+  // seed with the closest particle and empty cell in each cell
+  mJumpFloodInitBound.Record(commandBuffer);
+  mJumpFloodSeeds.Barrier(
+      commandBuffer, vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead);
+
+  // halve the step from the largest power of two smaller than the size, with
+  // an additional step of one to correct most of the errors.
+  std::vector<int> steps;
+  int maxSize = std::max(mSize.x, mSize.y);
+  for (int step = 1; step < maxSize; step *= 2)
+  {
+    steps.insert(steps.begin(), step);
+  }
+  steps.push_back(1);
+
+  bool swapped = false;
+  for (int step : steps)
+  {
+    auto& bound = swapped ? mNewJumpFloodBound : mJumpFloodBound;
+    auto& seeds = swapped ? mJumpFloodSeeds : mNewJumpFloodSeeds;
+
+    bound.PushConstant(commandBuffer, step);
+    bound.Record(commandBuffer);
+    seeds.Barrier(commandBuffer, vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead);
+    swapped = !swapped;
+  }
+
+  auto& phiBound = swapped ? mNewJumpFloodPhiBound : mJumpFloodPhiBound;
+  phiBound.Record(commandBuffer);
+}
+
+void ParticleCount::TransferToGrid(vk::CommandBuffer commandBuffer)
+{
+  assert(mValid != nullptr);
+
+  commandBuffer.debugMarkerBeginEXT({"Particle to grid", {{0.71f, 0.15f, 0.48f, 1.0f}}},
+                                    mDevice.Loader());
+  mValid->Clear(commandBuffer);
+  mParticleToGridBound.Record(commandBuffer);
+  mValid->Barrier(commandBuffer, vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead);
+  commandBuffer.debugMarkerEndEXT(mDevice.Loader());
+}
+
+void ParticleCount::TransferFromGrid(vk::CommandBuffer commandBuffer)
+{
+  commandBuffer.debugMarkerBeginEXT({"Particle from grid", {{0.35f, 0.11f, 0.87f, 1.0f}}},
+                                    mDevice.Loader());
+  mParticleFromGridBound.PushConstant(commandBuffer, mSize.x, mSize.y, mAlpha);
+  mParticleFromGridBound.RecordIndirect(commandBuffer, mDispatchParams);
+  mParticles.Barrier(
+      commandBuffer, vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead);
+  commandBuffer.debugMarkerEndEXT(mDevice.Loader());
+}
+
 }  // namespace Fluid
 }  // namespace Vortex
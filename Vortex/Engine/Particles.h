@@ -31,6 +31,23 @@ VORTEX_API float DefaultParticleSize();
 class ParticleCount : public Renderer::RenderTexture
 {
 public:
+  /**
+   * @brief How the level set is calculated from the particles.
+   */
+  enum class PhiMethod
+  {
+    /**
+     * @brief Weighted average of the neighbouring particles, only correct
+     * close to the particles and needs to be re-initialised.
+     */
+    Kernel,
+    /**
+     * @brief Approximate distance to the particles everywhere, calculated by
+     * jump flooding in log2(N) passes.
+     */
+    JumpFlood,
+  };
+
   VORTEX_API ParticleCount(const Renderer::Device& device,
                            const glm::ivec2& size,
                            Renderer::GenericBuffer& particles,
@@ -45,6 +62,19 @@ public:
    */
   VORTEX_API void Scan();
 
+  /**
+   * @brief Record the particle count and update of the internal data
+   * structures in a command buffer. The random seeds used when spawning
+   * particles are not updated, see @ref GenerateSeeds.
+   * @param commandBuffer command buffer to record into
+   */
+  VORTEX_API void Scan(vk::CommandBuffer commandBuffer);
+
+  /**
+   * @brief Generate new random seeds used to spawn particles.
+   */
+  VORTEX_API void GenerateSeeds();
+
   /**
    * @brief Calculate the total number of particles and return it.
    * @return
@@ -61,14 +91,21 @@ public:
    * @brief Bind a solid level set, which will be used to interpolate the
    * particles out of.
    * @param levelSet
+   * @param method how the level set is calculated
    */
-  VORTEX_API void LevelSetBind(LevelSet& levelSet);
+  VORTEX_API void LevelSetBind(LevelSet& levelSet, PhiMethod method = PhiMethod::Kernel);
 
   /**
    * @brief Calculate the level set from the particles.
    */
   VORTEX_API void Phi();
 
+  /**
+   * @brief Record the level set calculation in a command buffer.
+   * @param commandBuffer command buffer to record into
+   */
+  VORTEX_API void Phi(vk::CommandBuffer commandBuffer);
+
   /**
    * @brief Bind the velocities, used for advection of the particles.
    * @param velocity
@@ -81,19 +118,36 @@ public:
    */
   VORTEX_API void TransferToGrid();
 
+  /**
+   * @brief Record the transfer to the velocities field in a command buffer.
+   * @param commandBuffer command buffer to record into
+   */
+  VORTEX_API void TransferToGrid(vk::CommandBuffer commandBuffer);
+
   /**
    * @brief Interpolate the velocities field in to the particles' velocity.
    */
   VORTEX_API void TransferFromGrid();
 
+  /**
+   * @brief Record the transfer from the velocities field in a command buffer.
+   * @param commandBuffer command buffer to record into
+   */
+  VORTEX_API void TransferFromGrid(vk::CommandBuffer commandBuffer);
+
 private:
+  void RecordJumpFlood(vk::CommandBuffer commandBuffer);
+
   const Renderer::Device& mDevice;
   glm::ivec2 mSize;
   Renderer::GenericBuffer& mParticles;
+  LevelSet* mLevelSet;
+  Renderer::GenericBuffer* mValid;
   Renderer::Buffer<Particle> mNewParticles;
   Renderer::Buffer<int> mDelta, mCount;
   Renderer::Buffer<int> mIndex;
   Renderer::Buffer<glm::ivec2> mSeeds;
+  Renderer::Buffer<glm::ivec2> mJumpFloodSeeds, mNewJumpFloodSeeds;
 
   Renderer::IndirectBuffer<Renderer::DispatchParams> mDispatchParams;
   Renderer::Buffer<Renderer::DispatchParams> mLocalDispatchParams, mNewDispatchParams;
@@ -110,6 +164,12 @@ private:
   Renderer::Work::Bound mParticleSpawnBound;
   Renderer::Work mParticlePhiWork;
   Renderer::Work::Bound mParticlePhiBound;
+  Renderer::Work mJumpFloodInitWork;
+  Renderer::Work::Bound mJumpFloodInitBound;
+  Renderer::Work mJumpFloodWork;
+  Renderer::Work::Bound mJumpFloodBound, mNewJumpFloodBound;
+  Renderer::Work mJumpFloodPhiWork;
+  Renderer::Work::Bound mJumpFloodPhiBound, mNewJumpFloodPhiBound;
   Renderer::Work mParticleToGridWork;
   Renderer::Work::Bound mParticleToGridBound;
   Renderer::Work mParticleFromGridWork;
@@ -121,6 +181,7 @@ private:
   Renderer::CommandBuffer mParticleToGrid;
   Renderer::CommandBuffer mParticleFromGrid;
 
+  PhiMethod mPhiMethod;
   float mAlpha;
 };
 
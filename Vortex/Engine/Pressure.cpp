@@ -6,6 +6,7 @@
 #include "Pressure.h"
 
 #include <Vortex/Renderer/Pipeline.h>
+#include <Vortex/Renderer/PipelineBarrier.h>
 
 #include "vortex_generated_spirv.h"
 
@@ -22,7 +23,10 @@ Pressure::Pressure(const Renderer::Device& device,
                    Renderer::Texture& liquidPhi,
                    Renderer::GenericBuffer& valid)
     : mDevice(device)
+    , mDelta(dt)
     , mData(data)
+    , mVelocity(velocity)
+    , mValid(valid)
     , mBuildMatrix(device, size, SPIRV::BuildMatrix_comp)
     , mBuildMatrixBound(mBuildMatrix.Bind({data.Diagonal, data.Lower, liquidPhi, solidPhi}))
     , mBuildDiv(device, size, SPIRV::BuildDiv_comp)
@@ -31,32 +35,14 @@ Pressure::Pressure(const Renderer::Device& device,
     , mProjectBound(
           mProject.Bind({data.X, liquidPhi, solidPhi, velocity, velocity.Output(), valid}))
     , mBuildEquationCmd(device, false)
+    , mBuildDivergenceCmd(device, false)
     , mProjectCmd(device, false)
 {
-  mBuildEquationCmd.Record([&](vk::CommandBuffer commandBuffer) {
-    commandBuffer.debugMarkerBeginEXT({"Build equations", {{0.02f, 0.68f, 0.84f, 1.0f}}},
-                                      mDevice.Loader());
-    mBuildMatrixBound.PushConstant(commandBuffer, dt);
-    mBuildMatrixBound.Record(commandBuffer);
-    data.Diagonal.Barrier(
-        commandBuffer, vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead);
-    data.Lower.Barrier(
-        commandBuffer, vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead);
-    mBuildDivBound.Record(commandBuffer);
-    data.B.Barrier(
-        commandBuffer, vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead);
-    commandBuffer.debugMarkerEndEXT(mDevice.Loader());
-  });
-
-  mProjectCmd.Record([&](vk::CommandBuffer commandBuffer) {
-    commandBuffer.debugMarkerBeginEXT({"Pressure", {{0.45f, 0.47f, 0.75f, 1.0f}}},
-                                      mDevice.Loader());
-    valid.Clear(commandBuffer);
-    mProjectBound.PushConstant(commandBuffer, dt);
-    mProjectBound.Record(commandBuffer);
-    velocity.CopyBack(commandBuffer);
-    commandBuffer.debugMarkerEndEXT(mDevice.Loader());
-  });
+  mBuildEquationCmd.Record(
+      [&](vk::CommandBuffer commandBuffer) { BuildLinearEquation(commandBuffer); });
+  mBuildDivergenceCmd.Record(
+      [&](vk::CommandBuffer commandBuffer) { BuildDivergence(commandBuffer); });
+  mProjectCmd.Record([&](vk::CommandBuffer commandBuffer) { ApplyPressure(commandBuffer); });
 }
 
 Renderer::Work::Bound Pressure::BindMatrixBuild(const glm::ivec2& size,
@@ -73,10 +59,47 @@ void Pressure::BuildLinearEquation()
   mBuildEquationCmd.Submit();
 }
 
+void Pressure::BuildDivergence()
+{
+  mBuildDivergenceCmd.Submit();
+}
+
 void Pressure::ApplyPressure()
 {
   mProjectCmd.Submit();
 }
 
+void Pressure::BuildLinearEquation(vk::CommandBuffer commandBuffer)
+{
+  commandBuffer.debugMarkerBeginEXT({"Build equations", {{0.02f, 0.68f, 0.84f, 1.0f}}},
+                                    mDevice.Loader());
+  mBuildMatrixBound.PushConstant(commandBuffer, mDelta);
+  mBuildMatrixBound.Record(commandBuffer);
+  Renderer::ComputeBarrier(commandBuffer, {mData.Diagonal, mData.Lower});
+  mBuildDivBound.Record(commandBuffer);
+  mData.B.Barrier(commandBuffer, vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead);
+  commandBuffer.debugMarkerEndEXT(mDevice.Loader());
+}
+
+void Pressure::BuildDivergence(vk::CommandBuffer commandBuffer)
+{
+  commandBuffer.debugMarkerBeginEXT({"Build divergence", {{0.02f, 0.68f, 0.84f, 1.0f}}},
+                                    mDevice.Loader());
+  mBuildDivBound.Record(commandBuffer);
+  mData.B.Barrier(commandBuffer, vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead);
+  commandBuffer.debugMarkerEndEXT(mDevice.Loader());
+}
+
+void Pressure::ApplyPressure(vk::CommandBuffer commandBuffer)
+{
+  commandBuffer.debugMarkerBeginEXT({"Pressure", {{0.45f, 0.47f, 0.75f, 1.0f}}},
+                                    mDevice.Loader());
+  mValid.Clear(commandBuffer);
+  mProjectBound.PushConstant(commandBuffer, mDelta);
+  mProjectBound.Record(commandBuffer);
+  mVelocity.CopyBack(commandBuffer);
+  commandBuffer.debugMarkerEndEXT(mDevice.Loader());
+}
+
 }  // namespace Fluid
 }  // namespace Vortex
@@ -53,15 +53,43 @@ public:
    */
   VORTEX_API void BuildLinearEquation();
 
+  /**
+   * @brief Record the build of the matrix A and right hand side b in a command
+   * buffer.
+   * @param commandBuffer command buffer to record into
+   */
+  VORTEX_API void BuildLinearEquation(vk::CommandBuffer commandBuffer);
+
+  /**
+   * @brief Build only the right hand side b, keeping the matrix A of the
+   * previous build. Used when the level sets haven't changed.
+   */
+  VORTEX_API void BuildDivergence();
+
+  /**
+   * @brief Record the build of the right hand side b in a command buffer.
+   * @param commandBuffer command buffer to record into
+   */
+  VORTEX_API void BuildDivergence(vk::CommandBuffer commandBuffer);
+
   /**
    * @brief Apply the solution of the equation Ax = b, i.e. the pressure to the
    * velocity to make it non-divergent.
    */
   VORTEX_API void ApplyPressure();
 
+  /**
+   * @brief Record the application of the pressure in a command buffer.
+   * @param commandBuffer command buffer to record into
+   */
+  VORTEX_API void ApplyPressure(vk::CommandBuffer commandBuffer);
+
 private:
   const Renderer::Device& mDevice;
+  float mDelta;
   LinearSolver::Data& mData;
+  Velocity& mVelocity;
+  Renderer::GenericBuffer& mValid;
   Renderer::Work mBuildMatrix;
   Renderer::Work::Bound mBuildMatrixBound;
   Renderer::Work mBuildDiv;
@@ -69,6 +97,7 @@ private:
   Renderer::Work mProject;
   Renderer::Work::Bound mProjectBound;
   Renderer::CommandBuffer mBuildEquationCmd;
+  Renderer::CommandBuffer mBuildDivergenceCmd;
   Renderer::CommandBuffer mProjectCmd;
 };
 
@@ -32,6 +32,8 @@ RigidBody::RigidBody(const Renderer::Device& device,
     , mCenter(device, VMA_MEMORY_USAGE_CPU_TO_GPU)
     , mLocalVelocity(device, VMA_MEMORY_USAGE_CPU_ONLY)
     , mClear({1000.0f, 0.0f, 0.0f, 0.0f})
+    , mPhiRendered(false)
+    , mPhiRotation(0.0f)
     , mDiv(device, size, SPIRV::BuildRigidbodyDiv_comp)
     , mConstrain(device, size, SPIRV::ConstrainRigidbodyVelocity_comp)
     , mForceWork(device, size, SPIRV::RigidbodyForce_comp)
@@ -97,6 +99,18 @@ void RigidBody::RenderPhi()
   Transformable::Update();
   mLocalPhiRender.Submit(GetTransform());
   mPhiRender.Submit(GetTransform());
+
+  mPhiRendered = true;
+  mPhiPosition = Position;
+  mPhiScale = Scale;
+  mPhiAnchor = Anchor;
+  mPhiRotation = Rotation;
+}
+
+bool RigidBody::IsMoved() const
+{
+  return !mPhiRendered || Position != mPhiPosition || Scale != mPhiScale ||
+         Anchor != mPhiAnchor || Rotation != mPhiRotation;
 }
 
 void RigidBody::BindPhi(Renderer::RenderTexture& phi)
@@ -97,6 +97,12 @@ public:
    */
   VORTEX_API void RenderPhi();
 
+  /**
+   * @brief If the position, scale, rotation or anchor changed since the last
+   * call to @ref RenderPhi, or it was never called.
+   */
+  VORTEX_API bool IsMoved() const;
+
   /**
    * @brief Bind the rendertexture where this rigidbodies shape will be rendered
    * @param phi render texture of the world
@@ -195,6 +201,10 @@ private:
   Renderer::Clear mClear;
   Renderer::RenderCommand mLocalPhiRender, mPhiRender;
 
+  bool mPhiRendered;
+  glm::vec2 mPhiPosition, mPhiScale, mPhiAnchor;
+  float mPhiRotation;
+
   Renderer::Work mDiv, mConstrain, mForceWork, mPressureWork;
   Renderer::Work::Bound mDivBound, mConstrainBound, mForceBound, mPressureForceBound,
       mPressureBound;
@@ -25,11 +25,18 @@ class Velocity : public Renderer::RenderTexture
 public:
   /**
    * @brief Velocity interpolation when querying in the shader with non-integer locations.
+   * The sampler modes use the hardware filtering in the advection, with four
+   * times less fetches. LinearSampler is bilinear filtering and CubicSampler a
+   * cubic b-spline, which is smoother than Cubic. They require linear
+   * filtering of 32 bit float textures, @ref Advection throws if the device
+   * doesn't support it.
    */
   enum class InterpolationMode : int
   {
     Linear = 0,
     Cubic = 1,
+    LinearSampler = 2,
+    CubicSampler = 3,
   };
 
   VORTEX_API Velocity(const Renderer::Device& device, const glm::ivec2& size);
@@ -65,12 +72,24 @@ public:
    */
   VORTEX_API void SaveCopy();
 
+  /**
+   * @brief Record the copy to the difference field in a command buffer.
+   * @param commandBuffer command buffer to record into
+   */
+  VORTEX_API void SaveCopy(vk::CommandBuffer commandBuffer);
+
   /**
    * @brief Calculate the difference between the difference field and this
    * velocity field, store it in the diference field.
    */
   VORTEX_API void VelocityDiff();
 
+  /**
+   * @brief Record the difference calculation in a command buffer.
+   * @param commandBuffer command buffer to record into
+   */
+  VORTEX_API void VelocityDiff(vk::CommandBuffer commandBuffer);
+
 private:
   const Renderer::Device& mDevice;
   Renderer::Texture mOutputVelocity;
@@ -8,6 +8,8 @@
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/gtx/transform.hpp>
 
+#include <algorithm>
+
 namespace Vortex
 {
 namespace Fluid
@@ -21,59 +23,46 @@ void ForAll(std::vector<Class*>& elements, void (Class::*f)())
   }
 }
 
-uint32_t NextPowerOfTwo(uint32_t n)
-{
-  --n;
-
-  n |= n >> 1;
-  n |= n >> 2;
-  n |= n >> 4;
-  n |= n >> 8;
-  n |= n >> 16;
-
-  return n + 1;
-}
-
-glm::ivec2 NextPowerOfTwo(const glm::ivec2& s)
-{
-  return {NextPowerOfTwo(s.x), NextPowerOfTwo(s.y)};
-}
-
 World::World(const Renderer::Device& device,
              const glm::ivec2& size,
              float dt,
              int numSubSteps,
-             Velocity::InterpolationMode interpolationMode)
+             Velocity::InterpolationMode interpolationMode,
+             Advection::Integrator integrator)
     : mDevice(device)
     , mSize(size)
     , mDelta(dt / numSubSteps)
     , mNumSubSteps(numSubSteps)
-    , mSolverSize(NextPowerOfTwo(size))
-    , mPreconditioner(device, mSolverSize, mDelta)
-    , mLinearSolver(device, mSolverSize, mPreconditioner)
-    , mData(device, mSolverSize)
+    , mPreconditioner(device, size, mDelta)
+    , mLinearSolver(device, size, mPreconditioner)
+    , mData(device, size)
 #if !defined(NDEBUG)
-    , mDebugData(device, mSolverSize)
-    , mDebugDataCopy(device, mSolverSize, mData, mDebugData)
+    , mDebugData(device, size)
+    , mDebugDataCopy(device, size, mData, mDebugData)
 #endif
     , mVelocity(device, size)
     , mLiquidPhi(device, size)
     , mStaticSolidPhi(device, size)
     , mDynamicSolidPhi(device, size)
     , mValid(device, size.x * size.y)
-    , mAdvection(device, size, mDelta, mVelocity, interpolationMode)
+    , mAdvection(device, size, mDelta, mVelocity, interpolationMode, integrator)
     , mProjection(device,
                   mDelta,
-                  mSolverSize,
+                  size,
                   mData,
                   mVelocity,
                   mDynamicSolidPhi,
                   mLiquidPhi,
                   mValid)
-    , mExtrapolation(device, size, mValid, mVelocity)
+    , mExtrapolation(device, size, mValid, mVelocity, 10, Extrapolation::Method::Front)
     , mCopySolidPhi(device, false)
     , mRigidBodySolver(nullptr)
     , mCfl(device, size, mVelocity)
+    , mSolidPhiComposed(false)
+    , mBoundariesBuilt(false)
+    , mStaticSolidPhiVersion(0)
+    , mLiquidPhiVersion(0)
+    , mBakedIterations(0)
 {
   mExtrapolation.ConstrainBind(mDynamicSolidPhi);
   mLiquidPhi.ExtrapolateBind(mDynamicSolidPhi);
@@ -92,12 +81,72 @@ World::World(const Renderer::Device& device,
 
 void World::Step(LinearSolver::Parameters& params)
 {
+  if (mBakedStep)
+  {
+    // previous step needs to be complete before updating and submitting again
+    mBakedStep->Wait();
+    UpdateBakedStep();
+    mBakedPreForces->Submit();
+    SubmitVelocities();
+    mBakedStep->Submit();
+
+    params.Reset();
+    params.OutIterations = mBakedIterations;
+    return;
+  }
+
   for (int i = 0; i < mNumSubSteps; i++)
   {
     Substep(params);
   }
 }
 
+void World::BakeStep(LinearSolver::Parameters& params)
+{
+  if (params.Type != LinearSolver::Parameters::SolverType::Fixed)
+  {
+    throw std::runtime_error("Baked step requires fixed solver parameters");
+  }
+
+  if (!mRigidbodies.empty())
+  {
+    throw std::runtime_error("Baked step does not support rigidbodies");
+  }
+
+  if (params.WarmStart)
+  {
+    throw std::runtime_error("Baked step does not support warm start");
+  }
+
+  auto bakedPreForces = std::make_unique<Renderer::CommandBuffer>(mDevice, false);
+  bakedPreForces->Record([&](vk::CommandBuffer commandBuffer) { RecordPreForces(commandBuffer); });
+
+  auto bakedStep = std::make_unique<Renderer::CommandBuffer>(mDevice, true);
+  bakedStep->Record([&](vk::CommandBuffer commandBuffer) {
+    for (int i = 0; i < mNumSubSteps; i++)
+    {
+      // The pre-forces of the first sub-step are recorded separately, so the
+      // velocities can be submitted in between.
+      if (i > 0)
+      {
+        RecordPreForces(commandBuffer);
+      }
+
+      RecordSubstep(commandBuffer, params.Iterations);
+    }
+  });
+
+  mBakedIterations = params.Iterations;
+  mBakedPreForces = std::move(bakedPreForces);
+  mBakedStep = std::move(bakedStep);
+}
+
+void World::ClearBakedStep()
+{
+  mBakedPreForces.reset();
+  mBakedStep.reset();
+}
+
 Renderer::RenderCommand World::RecordVelocity(Renderer::RenderTarget::DrawableList drawables,
                                               VelocityOp op)
 {
@@ -141,6 +190,8 @@ DistanceField World::SolidDistanceField()
 
 void World::AddRigidbody(RigidBody& rigidbody)
 {
+  ClearBakedStep();
+
   rigidbody.BindPhi(mDynamicSolidPhi);
   rigidbody.BindDiv(mData.B, mData.Diagonal);
   rigidbody.BindVelocityConstrain(mVelocity);
@@ -148,12 +199,17 @@ void World::AddRigidbody(RigidBody& rigidbody)
   rigidbody.BindForce(mData.Diagonal, mData.X);
 
   mRigidbodies.push_back(&rigidbody);
+  mSolidPhiComposed = false;
 }
 
 void World::RemoveRigidBody(RigidBody& rigidbody)
 {
   mRigidbodies.erase(std::remove(mRigidbodies.begin(), mRigidbodies.end(), &rigidbody),
                      mRigidbodies.end());
+
+  // the removed rigidbody is still in the solid level set and the matrix
+  mSolidPhiComposed = false;
+  mBoundariesBuilt = false;
 }
 
 void World::AttachRigidBodySolver(RigidBodySolver& rigidbodySolver)
@@ -161,6 +217,63 @@ void World::AttachRigidBodySolver(RigidBodySolver& rigidbodySolver)
   mRigidBodySolver = &rigidbodySolver;
 }
 
+void World::SubmitVelocities()
+{
+  for (auto& velocity : mVelocities)
+  {
+    velocity->Submit();
+  }
+  mVelocities.clear();
+}
+
+void World::RecordPreForces(vk::CommandBuffer /*commandBuffer*/) {}
+
+void World::UpdateBakedStep() {}
+
+bool World::UpdateSolidPhi()
+{
+  if (mStaticSolidPhi.GetVersion() != mStaticSolidPhiVersion)
+  {
+    mStaticSolidPhi.Reinitialise();
+    mStaticSolidPhiVersion = mStaticSolidPhi.GetVersion();
+    mSolidPhiComposed = false;
+  }
+
+  ForAll(mRigidbodies, &RigidBody::UpdatePosition);
+
+  bool moved = std::any_of(mRigidbodies.begin(), mRigidbodies.end(), [](RigidBody* rigidbody) {
+    return rigidbody->IsMoved();
+  });
+
+  if (mSolidPhiComposed && !moved)
+  {
+    return false;
+  }
+
+  // the static level set is already re-initialised, it only needs to be done
+  // again where the rigidbodies are drawn.
+  mCopySolidPhi.Submit();
+  if (!mRigidbodies.empty())
+  {
+    ForAll(mRigidbodies, &RigidBody::RenderPhi);
+    mDynamicSolidPhi.Reinitialise();
+  }
+
+  mSolidPhiComposed = true;
+  return true;
+}
+
+bool World::BoundariesChanged(bool solidPhiChanged)
+{
+  bool changed =
+      !mBoundariesBuilt || solidPhiChanged || mLiquidPhi.GetVersion() != mLiquidPhiVersion;
+
+  mBoundariesBuilt = true;
+  mLiquidPhiVersion = mLiquidPhi.GetVersion();
+
+  return changed;
+}
+
 void World::StepRigidBodies()
 {
   // Set Forces to rigid bodies
@@ -189,8 +302,9 @@ Renderer::Texture& World::GetVelocity()
 SmokeWorld::SmokeWorld(const Renderer::Device& device,
                        const glm::ivec2& size,
                        float dt,
-                       Velocity::InterpolationMode interpolationMode)
-    : World(device, size, dt, 1, interpolationMode)
+                       Velocity::InterpolationMode interpolationMode,
+                       Advection::Integrator integrator)
+    : World(device, size, dt, 1, interpolationMode, integrator)
 {
 }
 
@@ -198,20 +312,20 @@ SmokeWorld::~SmokeWorld() {}
 
 void SmokeWorld::Substep(LinearSolver::Parameters& params)
 {
-  for (auto& velocity : mVelocities)
-  {
-    velocity->Submit();
-  }
-  mVelocities.clear();
+  SubmitVelocities();
 
-  mCopySolidPhi.Submit();
+  bool solidPhiChanged = UpdateSolidPhi();
 
-  ForAll(mRigidbodies, &RigidBody::RenderPhi);
-  ForAll(mRigidbodies, &RigidBody::UpdatePosition);
-
-  mDynamicSolidPhi.Reinitialise();
-  mPreconditioner.BuildHierarchies();
-  mProjection.BuildLinearEquation();
+  // the matrix only depends on the level sets, the divergence on the velocity
+  if (BoundariesChanged(solidPhiChanged))
+  {
+    mPreconditioner.BuildHierarchies();
+    mProjection.BuildLinearEquation();
+  }
+  else
+  {
+    mProjection.BuildDivergence();
+  }
 
   ForAll(mRigidbodies, &RigidBody::Div);
 
@@ -235,24 +349,55 @@ void SmokeWorld::Substep(LinearSolver::Parameters& params)
   StepRigidBodies();
 }
 
+void SmokeWorld::RecordSubstep(vk::CommandBuffer commandBuffer, unsigned iterations)
+{
+  mDynamicSolidPhi.CopyFrom(commandBuffer, mStaticSolidPhi);
+  mDynamicSolidPhi.Reinitialise(commandBuffer);
+  mPreconditioner.BuildHierarchies(commandBuffer);
+  mProjection.BuildLinearEquation(commandBuffer);
+
+  mLinearSolver.RecordSolve(commandBuffer, iterations);
+  mProjection.ApplyPressure(commandBuffer);
+
+#if !defined(NDEBUG)
+  mDebugDataCopy.Copy(commandBuffer);
+#endif
+
+  mExtrapolation.Extrapolate(commandBuffer);
+  mExtrapolation.ConstrainVelocity(commandBuffer);
+
+  mAdvection.AdvectVelocity(commandBuffer);
+  mAdvection.Advect(commandBuffer);
+}
+
 void SmokeWorld::FieldBind(Density& density)
 {
+  ClearBakedStep();
   mAdvection.AdvectBind(density);
 }
 
+void SmokeWorld::FieldUnbind(Density& density)
+{
+  ClearBakedStep();
+  mAdvection.AdvectUnbind(density);
+}
+
 WaterWorld::WaterWorld(const Renderer::Device& device,
                        const glm::ivec2& size,
                        float dt,
                        int numSubSteps,
-                       Velocity::InterpolationMode interpolationMode)
-    : World(device, size, dt, numSubSteps, interpolationMode)
+                       Velocity::InterpolationMode interpolationMode,
+                       Advection::Integrator integrator)
+    : World(device, size, dt, numSubSteps, interpolationMode, integrator)
     , mParticles(device,
                  vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eVertexBuffer,
                  VMA_MEMORY_USAGE_GPU_ONLY,
                  8 * size.x * size.y * sizeof(Particle))
     , mParticleCount(device, size, mParticles, interpolationMode, {0}, 0.02f)
 {
-  mParticleCount.LevelSetBind(mLiquidPhi);
+  // the jump flooding gives a distance field, which doesn't need to be
+  // re-initialised
+  mParticleCount.LevelSetBind(mLiquidPhi, ParticleCount::PhiMethod::JumpFlood);
   mParticleCount.VelocitiesBind(mVelocity, mValid);
   mAdvection.AdvectParticleBind(mParticles, mDynamicSolidPhi, mParticleCount.GetDispatchParams());
 }
@@ -280,17 +425,10 @@ void WaterWorld::Substep(LinearSolver::Parameters& params)
   mVelocity.SaveCopy();
 
   // 3)
-  for (auto& velocity : mVelocities)
-  {
-    velocity->Submit();
-  }
-  mVelocities.clear();
+  SubmitVelocities();
 
   // 4)
-  mCopySolidPhi.Submit();
-  ForAll(mRigidbodies, &RigidBody::RenderPhi);
-  ForAll(mRigidbodies, &RigidBody::UpdatePosition);
-  mDynamicSolidPhi.Reinitialise();
+  UpdateSolidPhi();
 
   ForAll(mRigidbodies, &RigidBody::Div);
 
@@ -324,6 +462,46 @@ void WaterWorld::Substep(LinearSolver::Parameters& params)
   StepRigidBodies();
 }
 
+void WaterWorld::RecordPreForces(vk::CommandBuffer commandBuffer)
+{
+  mParticleCount.Scan(commandBuffer);
+  mParticleCount.Phi(commandBuffer);
+
+  mParticleCount.TransferToGrid(commandBuffer);
+  mExtrapolation.Extrapolate(commandBuffer);
+  mVelocity.SaveCopy(commandBuffer);
+}
+
+void WaterWorld::RecordSubstep(vk::CommandBuffer commandBuffer, unsigned iterations)
+{
+  mDynamicSolidPhi.CopyFrom(commandBuffer, mStaticSolidPhi);
+  mDynamicSolidPhi.Reinitialise(commandBuffer);
+
+  mPreconditioner.BuildHierarchies(commandBuffer);
+  mLiquidPhi.Extrapolate(commandBuffer);
+
+  mProjection.BuildLinearEquation(commandBuffer);
+  mLinearSolver.RecordSolve(commandBuffer, iterations);
+  mProjection.ApplyPressure(commandBuffer);
+
+#if !defined(NDEBUG)
+  mDebugDataCopy.Copy(commandBuffer);
+#endif
+
+  mExtrapolation.Extrapolate(commandBuffer);
+  mExtrapolation.ConstrainVelocity(commandBuffer);
+
+  mVelocity.VelocityDiff(commandBuffer);
+  mParticleCount.TransferFromGrid(commandBuffer);
+
+  mAdvection.AdvectParticles(commandBuffer);
+}
+
+void WaterWorld::UpdateBakedStep()
+{
+  mParticleCount.GenerateSeeds();
+}
+
 Renderer::RenderCommand WaterWorld::RecordParticleCount(
     Renderer::RenderTarget::DrawableList drawables)
 {
@@ -334,7 +512,6 @@ void WaterWorld::ParticlePhi()
 {
   mParticleCount.Scan();
   mParticleCount.Phi();
-  mLiquidPhi.Reinitialise();
 }
 
 }  // namespace Fluid
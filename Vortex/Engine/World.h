@@ -55,12 +55,15 @@ public:
    * @param dt timestamp of the simulation, e.g. 0.016 for 60FPS simulations.
    * @param numSubSteps the number of sub-steps to perform per step call.
    * Reduces loss of fluid.
+   * @param interpolationMode velocity interpolation
+   * @param integrator integrator of the advection
    */
   World(const Renderer::Device& device,
         const glm::ivec2& size,
         float dt,
         int numSubSteps = 1,
-        Velocity::InterpolationMode interpolationMode = Velocity::InterpolationMode::Linear);
+        Velocity::InterpolationMode interpolationMode = Velocity::InterpolationMode::Linear,
+        Advection::Integrator integrator = Advection::Integrator::RK3);
   virtual ~World() = default;
 
   /**
@@ -68,6 +71,23 @@ public:
    */
   VORTEX_API void Step(LinearSolver::Parameters& params);
 
+  /**
+   * @brief Record all the sub-steps of a step, including a fixed number of
+   * iterations of the linear solver, in pre-recorded command buffers. The
+   * following calls to @ref Step will only submit those command buffers, which
+   * removes most of the CPU cost of a step. Rigidbodies are not supported, and
+   * adding one will clear the baked step.
+   * @param params solver parameters, must be of fixed type and without warm
+   * start
+   */
+  VORTEX_API void BakeStep(LinearSolver::Parameters& params);
+
+  /**
+   * @brief Clear the baked step, @ref Step will submit each stage separately
+   * again.
+   */
+  VORTEX_API void ClearBakedStep();
+
   /**
    * @brief Record drawables to the velocity field. The colour (r,g) will be
    * used as the velocity (x, y)
@@ -148,15 +168,50 @@ public:
   VORTEX_API Renderer::Texture& GetVelocity();
 
 protected:
+  void SubmitVelocities();
   void StepRigidBodies();
+
+  /**
+   * @brief Compose the solid level set from the static one and the
+   * rigidbodies. The static level set is re-initialised once when it changes
+   * and then kept, the composition is skipped if it didn't change and no
+   * rigidbody moved.
+   * @return if the solid level set changed
+   */
+  bool UpdateSolidPhi();
+
+  /**
+   * @brief If the level sets changed since the last call, in which case the
+   * multigrid hierarchy and the matrix of the linear equations are rebuilt.
+   * @param solidPhiChanged if the solid level set changed, see
+   * @ref UpdateSolidPhi
+   */
+  bool BoundariesChanged(bool solidPhiChanged);
   virtual void Substep(LinearSolver::Parameters& params) = 0;
 
+  /**
+   * @brief Record the part of a sub-step that happens before the velocities
+   * from @ref RecordVelocity are applied.
+   */
+  virtual void RecordPreForces(vk::CommandBuffer commandBuffer);
+
+  /**
+   * @brief Record the part of a sub-step that happens after the velocities
+   * from @ref RecordVelocity are applied.
+   */
+  virtual void RecordSubstep(vk::CommandBuffer commandBuffer, unsigned iterations) = 0;
+
+  /**
+   * @brief Update CPU side data used by the baked step, called before each
+   * submission.
+   */
+  virtual void UpdateBakedStep();
+
   const Renderer::Device& mDevice;
   glm::ivec2 mSize;
   float mDelta;
   int mNumSubSteps;
 
-  glm::ivec2 mSolverSize;
   Multigrid mPreconditioner;
   ConjugateGradient mLinearSolver;
 
@@ -185,6 +240,15 @@ protected:
   std::vector<Renderer::RenderCommand*> mVelocities;
 
   Cfl mCfl;
+
+  bool mSolidPhiComposed;
+  bool mBoundariesBuilt;
+  uint64_t mStaticSolidPhiVersion;
+  uint64_t mLiquidPhiVersion;
+
+  unsigned mBakedIterations;
+  std::unique_ptr<Renderer::CommandBuffer> mBakedPreForces;
+  std::unique_ptr<Renderer::CommandBuffer> mBakedStep;
 };
 
 /**
@@ -197,17 +261,26 @@ public:
   VORTEX_API SmokeWorld(const Renderer::Device& device,
                         const glm::ivec2& size,
                         float dt,
-                        Velocity::InterpolationMode interpolationMode);
+                        Velocity::InterpolationMode interpolationMode,
+                        Advection::Integrator integrator = Advection::Integrator::RK3);
   VORTEX_API ~SmokeWorld() override;
 
   /**
-   * @brief Bind a density field to be moved around with the fluid
+   * @brief Bind a density field to be moved around with the fluid, in
+   * addition to the ones already bound. A field already bound is ignored.
    * @param density the density field
    */
   VORTEX_API void FieldBind(Density& density);
 
+  /**
+   * @brief Unbind a density field, which must be done before it is destroyed.
+   * @param density the density field
+   */
+  VORTEX_API void FieldUnbind(Density& density);
+
 private:
   void Substep(LinearSolver::Parameters& params) override;
+  void RecordSubstep(vk::CommandBuffer commandBuffer, unsigned iterations) override;
 };
 
 /**
@@ -220,7 +293,8 @@ public:
                         const glm::ivec2& size,
                         float dt,
                         int numSubSteps,
-                        Velocity::InterpolationMode interpolationMode);
+                        Velocity::InterpolationMode interpolationMode,
+                        Advection::Integrator integrator = Advection::Integrator::RK3);
   VORTEX_API ~WaterWorld() override;
 
   /**
@@ -243,6 +317,9 @@ public:
 
 private:
   void Substep(LinearSolver::Parameters& params) override;
+  void RecordPreForces(vk::CommandBuffer commandBuffer) override;
+  void RecordSubstep(vk::CommandBuffer commandBuffer, unsigned iterations) override;
+  void UpdateBakedStep() override;
 
   Renderer::GenericBuffer mParticles;
   ParticleCount mParticleCount;
@@ -17,6 +17,21 @@ void BufferBarrier(vk::Buffer buffer,
                    vk::CommandBuffer commandBuffer,
                    vk::AccessFlags oldAccess,
                    vk::AccessFlags newAccess)
+{
+  BufferBarrier(buffer,
+                commandBuffer,
+                vk::PipelineStageFlagBits::eAllCommands,
+                oldAccess,
+                vk::PipelineStageFlagBits::eAllCommands,
+                newAccess);
+}
+
+void BufferBarrier(vk::Buffer buffer,
+                   vk::CommandBuffer commandBuffer,
+                   vk::PipelineStageFlags srcStage,
+                   vk::AccessFlags oldAccess,
+                   vk::PipelineStageFlags dstStage,
+                   vk::AccessFlags newAccess)
 {
   auto bufferMemoryBarriers = vk::BufferMemoryBarrier()
                                   .setSrcQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
@@ -26,12 +41,7 @@ void BufferBarrier(vk::Buffer buffer,
                                   .setSrcAccessMask(oldAccess)
                                   .setDstAccessMask(newAccess);
 
-  commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eAllCommands,
-                                vk::PipelineStageFlagBits::eAllCommands,
-                                {},
-                                nullptr,
-                                bufferMemoryBarriers,
-                                nullptr);
+  commandBuffer.pipelineBarrier(srcStage, dstStage, {}, nullptr, bufferMemoryBarriers, nullptr);
 }
 
 GenericBuffer::GenericBuffer(const Device& device,
@@ -168,6 +178,15 @@ void GenericBuffer::Barrier(vk::CommandBuffer commandBuffer,
   BufferBarrier(mBuffer, commandBuffer, oldAccess, newAccess);
 }
 
+void GenericBuffer::Barrier(vk::CommandBuffer commandBuffer,
+                            vk::PipelineStageFlags srcStage,
+                            vk::AccessFlags oldAccess,
+                            vk::PipelineStageFlags dstStage,
+                            vk::AccessFlags newAccess)
+{
+  BufferBarrier(mBuffer, commandBuffer, srcStage, oldAccess, dstStage, newAccess);
+}
+
 void GenericBuffer::Clear(vk::CommandBuffer commandBuffer)
 {
   Barrier(commandBuffer, vk::AccessFlagBits::eShaderRead, vk::AccessFlagBits::eTransferWrite);
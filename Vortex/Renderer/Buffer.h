@@ -70,6 +70,20 @@ public:
                           vk::AccessFlags oldAccess,
                           vk::AccessFlags newAccess);
 
+  /**
+   * @brief Inserts a barrier for this buffer between specific pipeline stages
+   * @param commandBuffer the command buffer to run the barrier
+   * @param srcStage pipeline stages of the old access
+   * @param oldAccess old access
+   * @param dstStage pipeline stages of the new access
+   * @param newAccess new access
+   */
+  VORTEX_API void Barrier(vk::CommandBuffer commandBuffer,
+                          vk::PipelineStageFlags srcStage,
+                          vk::AccessFlags oldAccess,
+                          vk::PipelineStageFlags dstStage,
+                          vk::AccessFlags newAccess);
+
   /**
    * @brief Clear the buffer with 0
    * @param commandBuffer the command buffer to clear on
@@ -241,5 +255,22 @@ VORTEX_API void BufferBarrier(vk::Buffer buffer,
                               vk::AccessFlags oldAccess,
                               vk::AccessFlags newAccess);
 
+/**
+ * @brief Inserts a barrier for the given buffer, command buffer, pipeline
+ * stages and access.
+ * @param buffer the vulkan buffer handle
+ * @param commandBuffer the command buffer to inserts the barrier
+ * @param srcStage pipeline stages of the old access
+ * @param oldAccess old access
+ * @param dstStage pipeline stages of the new access
+ * @param newAccess new access
+ */
+VORTEX_API void BufferBarrier(vk::Buffer buffer,
+                              vk::CommandBuffer commandBuffer,
+                              vk::PipelineStageFlags srcStage,
+                              vk::AccessFlags oldAccess,
+                              vk::PipelineStageFlags dstStage,
+                              vk::AccessFlags newAccess);
+
 }  // namespace Renderer
 }  // namespace Vortex
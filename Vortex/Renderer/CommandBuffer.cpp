@@ -7,6 +7,7 @@
 
 #include <Vortex/Renderer/Device.h>
 #include <Vortex/Renderer/Drawable.h>
+#include <Vortex/Renderer/Profiler.h>
 #include <Vortex/Renderer/RenderTarget.h>
 
 namespace Vortex
@@ -69,7 +70,7 @@ CommandBuffer& CommandBuffer::Record(CommandBuffer::CommandFn commandFn)
   auto bufferBegin =
       vk::CommandBufferBeginInfo().setFlags(vk::CommandBufferUsageFlagBits::eSimultaneousUse);
 
-  mCommandBuffer.begin(bufferBegin);
+  mCommandBuffer.begin(bufferBegin, mDevice.Loader());
   commandFn(mCommandBuffer);
   mCommandBuffer.end();
   mRecorded = true;
@@ -86,7 +87,7 @@ CommandBuffer& CommandBuffer::Record(const RenderTarget& renderTarget,
   auto bufferBegin =
       vk::CommandBufferBeginInfo().setFlags(vk::CommandBufferUsageFlagBits::eSimultaneousUse);
 
-  mCommandBuffer.begin(bufferBegin);
+  mCommandBuffer.begin(bufferBegin, mDevice.Loader());
 
   auto renderPassBegin = vk::RenderPassBeginInfo()
                              .setFramebuffer(framebuffer)
@@ -108,7 +109,14 @@ CommandBuffer& CommandBuffer::Wait()
 {
   if (mSynchronise)
   {
+    auto start = Profiler::Clock::now();
     mDevice.Handle().waitForFences({*mFence}, true, UINT64_MAX);
+
+    auto profiler = mDevice.GetProfiler();
+    if (profiler != nullptr)
+    {
+      profiler->Wait(start);
+    }
   }
 
   return *this;
@@ -130,6 +138,8 @@ CommandBuffer& CommandBuffer::Submit(const std::initializer_list<vk::Semaphore>&
   if (!mRecorded)
     throw std::runtime_error("Submitting a command that wasn't recorded");
 
+  auto start = Profiler::Clock::now();
+
   Reset();
 
   std::vector<vk::PipelineStageFlags> waitStages(waitSemaphores.size(),
@@ -153,6 +163,12 @@ CommandBuffer& CommandBuffer::Submit(const std::initializer_list<vk::Semaphore>&
     mDevice.Queue().submit({submitInfo}, nullptr);
   }
 
+  auto profiler = mDevice.GetProfiler();
+  if (profiler != nullptr)
+  {
+    profiler->Submit(mCommandBuffer, start);
+  }
+
   return *this;
 }
 
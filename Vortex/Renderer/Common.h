@@ -24,3 +24,23 @@
 #else
 #define VORTEX_API
 #endif
+
+#include <functional>
+
+namespace Vortex
+{
+namespace Renderer
+{
+/**
+ * @brief Combine the hash of a value into an existing hash.
+ * @param seed the existing hash
+ * @param value the value to hash
+ */
+template <typename T>
+inline void HashCombine(std::size_t& seed, const T& value)
+{
+  seed ^= std::hash<T>()(value) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+}
+
+}  // namespace Renderer
+}  // namespace Vortex
@@ -32,34 +32,128 @@ ShaderLayout::ShaderLayout(const SPIRV::Reflection& reflection)
 {
 }
 
-LayoutManager::LayoutManager(const Device& device) : mDevice(device) {}
+PooledDescriptorSet::PooledDescriptorSet() : mDescriptorSet(nullptr), mFreeSets(nullptr) {}
+
+PooledDescriptorSet::PooledDescriptorSet(vk::DescriptorSet descriptorSet,
+                                         std::vector<vk::DescriptorSet>& freeSets)
+    : mDescriptorSet(descriptorSet), mFreeSets(&freeSets)
+{
+}
+
+PooledDescriptorSet::~PooledDescriptorSet()
+{
+  if (mFreeSets != nullptr)
+  {
+    mFreeSets->push_back(mDescriptorSet);
+  }
+}
+
+PooledDescriptorSet::PooledDescriptorSet(PooledDescriptorSet&& other)
+    : mDescriptorSet(other.mDescriptorSet), mFreeSets(other.mFreeSets)
+{
+  other.mDescriptorSet = nullptr;
+  other.mFreeSets = nullptr;
+}
+
+PooledDescriptorSet& PooledDescriptorSet::operator=(PooledDescriptorSet&& other)
+{
+  if (this != &other)
+  {
+    if (mFreeSets != nullptr)
+    {
+      mFreeSets->push_back(mDescriptorSet);
+    }
+
+    mDescriptorSet = other.mDescriptorSet;
+    mFreeSets = other.mFreeSets;
+
+    other.mDescriptorSet = nullptr;
+    other.mFreeSets = nullptr;
+  }
+
+  return *this;
+}
+
+LayoutManager::LayoutManager(const Device& device)
+    : mDevice(device), mPoolSize(0), mNumAllocatedSets(0)
+{
+}
 
 void LayoutManager::CreateDescriptorPool(int size)
 {
-  // create descriptor pool
+  // the sets still in use would be returned to the free lists after their
+  // pool was destroyed, and then be re-used.
+  auto statistics = GetStatistics();
+  if (statistics.NumAllocatedSets != statistics.NumFreeSets)
+  {
+    throw std::runtime_error("Descriptor sets still in use when re-creating the descriptor pools");
+  }
+
+  mPoolSize = static_cast<uint32_t>(size);
+  mNumAllocatedSets = 0;
+  mDescriptorPools.clear();
+  for (auto& descriptorSetLayout : mDescriptorSetLayouts)
+  {
+    descriptorSetLayout.second.FreeSets.clear();
+  }
+
+  AddDescriptorPool();
+}
+
+void LayoutManager::AddDescriptorPool()
+{
+  // sets are never freed individually but re-used, so the pools don't need
+  // the free descriptor set flag.
+  DescriptorPool descriptorPool;
+  descriptorPool.FreeSets = mPoolSize;
+  descriptorPool.FreeDescriptors = {{vk::DescriptorType::eUniformBuffer, mPoolSize},
+                                    {vk::DescriptorType::eCombinedImageSampler, mPoolSize},
+                                    {vk::DescriptorType::eStorageImage, mPoolSize},
+                                    {vk::DescriptorType::eStorageBuffer, mPoolSize}};
+
   std::vector<vk::DescriptorPoolSize> poolSizes;
-  poolSizes.emplace_back(vk::DescriptorType::eUniformBuffer, size);
-  poolSizes.emplace_back(vk::DescriptorType::eCombinedImageSampler, size);
-  poolSizes.emplace_back(vk::DescriptorType::eStorageImage, size);
-  poolSizes.emplace_back(vk::DescriptorType::eStorageBuffer, size);
+  for (auto& freeDescriptors : descriptorPool.FreeDescriptors)
+  {
+    poolSizes.emplace_back(freeDescriptors.first, freeDescriptors.second);
+  }
 
   vk::DescriptorPoolCreateInfo descriptorPoolInfo{};
-  descriptorPoolInfo.flags = vk::DescriptorPoolCreateFlagBits::eFreeDescriptorSet;
-  descriptorPoolInfo.maxSets = 512;
+  descriptorPoolInfo.maxSets = mPoolSize;
   descriptorPoolInfo.poolSizeCount = (uint32_t)poolSizes.size();
   descriptorPoolInfo.pPoolSizes = poolSizes.data();
-  mDescriptorPool = mDevice.Handle().createDescriptorPoolUnique(descriptorPoolInfo);
+  descriptorPool.Pool = mDevice.Handle().createDescriptorPoolUnique(descriptorPoolInfo);
+
+  mDescriptorPools.push_back(std::move(descriptorPool));
 }
 
-vk::DescriptorSetLayout LayoutManager::GetDescriptorSetLayout(const PipelineLayout& layout)
+bool LayoutManager::CanAllocate(const DescriptorPool& pool,
+                                const DescriptorSetLayoutCache& layout) const
 {
-  auto it = std::find_if(
-      mDescriptorSetLayouts.begin(),
-      mDescriptorSetLayouts.end(),
-      [&](const auto& descriptorSetLayout) { return std::get<0>(descriptorSetLayout) == layout; });
+  if (pool.FreeSets == 0)
+  {
+    return false;
+  }
+
+  for (auto& descriptors : layout.Descriptors)
+  {
+    auto it = pool.FreeDescriptors.find(descriptors.first);
+    if (it == pool.FreeDescriptors.end() || it->second < descriptors.second)
+    {
+      return false;
+    }
+  }
 
+  return true;
+}
+
+LayoutManager::DescriptorSetLayoutCache& LayoutManager::GetDescriptorSetLayoutCache(
+    const PipelineLayout& layout)
+{
+  auto it = mDescriptorSetLayouts.find(layout);
   if (it == mDescriptorSetLayouts.end())
   {
+    DescriptorSetLayoutCache cache;
+
     std::vector<vk::DescriptorSetLayoutBinding> descriptorSetLayoutBindings;
     for (auto& shaderLayout : layout.layouts)
     {
@@ -67,6 +161,7 @@ vk::DescriptorSetLayout LayoutManager::GetDescriptorSetLayout(const PipelineLayo
       {
         descriptorSetLayoutBindings.push_back(
             {desciptorType.first, desciptorType.second, 1, shaderLayout.shaderStage, nullptr});
+        cache.Descriptors[desciptorType.second]++;
       }
     }
 
@@ -75,22 +170,21 @@ vk::DescriptorSetLayout LayoutManager::GetDescriptorSetLayout(const PipelineLayo
             .setBindingCount((uint32_t)descriptorSetLayoutBindings.size())
             .setPBindings(descriptorSetLayoutBindings.data());
 
-    auto descriptorSetLayout =
-        mDevice.Handle().createDescriptorSetLayoutUnique(descriptorSetLayoutInfo);
-    mDescriptorSetLayouts.emplace_back(layout, std::move(descriptorSetLayout));
-    return *std::get<1>(mDescriptorSetLayouts.back());
+    cache.Layout = mDevice.Handle().createDescriptorSetLayoutUnique(descriptorSetLayoutInfo);
+    it = mDescriptorSetLayouts.emplace(layout, std::move(cache)).first;
   }
 
-  return *std::get<1>(*it);
+  return it->second;
 }
 
-vk::PipelineLayout LayoutManager::GetPipelineLayout(const PipelineLayout& layout)
+vk::DescriptorSetLayout LayoutManager::GetDescriptorSetLayout(const PipelineLayout& layout)
 {
-  auto it = std::find_if(
-      mPipelineLayouts.begin(), mPipelineLayouts.end(), [&](const auto& pipelineLayout) {
-        return std::get<0>(pipelineLayout) == layout;
-      });
+  return *GetDescriptorSetLayoutCache(layout).Layout;
+}
 
+vk::PipelineLayout LayoutManager::GetPipelineLayout(const PipelineLayout& layout)
+{
+  auto it = mPipelineLayouts.find(layout);
   if (it == mPipelineLayouts.end())
   {
     vk::DescriptorSetLayout descriptorSetlayouts[] = {GetDescriptorSetLayout(layout)};
@@ -115,32 +209,75 @@ vk::PipelineLayout LayoutManager::GetPipelineLayout(const PipelineLayout& layout
           .setPushConstantRangeCount((uint32_t)pushConstantRanges.size());
     }
 
-    mPipelineLayouts.emplace_back(layout,
-                                  mDevice.Handle().createPipelineLayoutUnique(pipelineLayoutInfo));
-    return *std::get<1>(mPipelineLayouts.back());
+    it = mPipelineLayouts
+             .emplace(layout, mDevice.Handle().createPipelineLayoutUnique(pipelineLayoutInfo))
+             .first;
   }
 
-  return *std::get<1>(*it);
+  return *it->second;
 }
 
 DescriptorSet LayoutManager::MakeDescriptorSet(const PipelineLayout& layout)
 {
-  vk::DescriptorSetLayout descriptorSetlayouts[] = {GetDescriptorSetLayout(layout)};
+  auto& cache = GetDescriptorSetLayoutCache(layout);
 
-  auto descriptorSetInfo = vk::DescriptorSetAllocateInfo()
-                               .setDescriptorPool(*mDescriptorPool)
-                               .setDescriptorSetCount(1)
-                               .setPSetLayouts(descriptorSetlayouts);
+  vk::DescriptorSet set;
+  if (!cache.FreeSets.empty())
+  {
+    set = cache.FreeSets.back();
+    cache.FreeSets.pop_back();
+  }
+  else
+  {
+    if (!CanAllocate(mDescriptorPools.back(), cache))
+    {
+      AddDescriptorPool();
+      if (!CanAllocate(mDescriptorPools.back(), cache))
+      {
+        throw std::runtime_error("Descriptor set layout too big for the descriptor pool");
+      }
+    }
+
+    auto& pool = mDescriptorPools.back();
+    vk::DescriptorSetLayout descriptorSetlayouts[] = {*cache.Layout};
+
+    auto descriptorSetInfo = vk::DescriptorSetAllocateInfo()
+                                 .setDescriptorPool(*pool.Pool)
+                                 .setDescriptorSetCount(1)
+                                 .setPSetLayouts(descriptorSetlayouts);
+
+    set = mDevice.Handle().allocateDescriptorSets(descriptorSetInfo).at(0);
+
+    pool.FreeSets--;
+    for (auto& descriptors : cache.Descriptors)
+    {
+      pool.FreeDescriptors[descriptors.first] -= descriptors.second;
+    }
+    mNumAllocatedSets++;
+  }
 
   DescriptorSet descriptorSet;
-  descriptorSet.descriptorSet =
-      std::move(mDevice.Handle().allocateDescriptorSetsUnique(descriptorSetInfo).at(0));
-  descriptorSet.descriptorSetLayout = GetDescriptorSetLayout(layout);
+  descriptorSet.descriptorSet = PooledDescriptorSet(set, cache.FreeSets);
+  descriptorSet.descriptorSetLayout = *cache.Layout;
   descriptorSet.pipelineLayout = GetPipelineLayout(layout);
 
   return descriptorSet;
 }
 
+LayoutManager::Statistics LayoutManager::GetStatistics() const
+{
+  Statistics statistics;
+  statistics.NumPools = static_cast<uint32_t>(mDescriptorPools.size());
+  statistics.NumAllocatedSets = mNumAllocatedSets;
+  statistics.NumFreeSets = 0;
+  for (auto& descriptorSetLayout : mDescriptorSetLayouts)
+  {
+    statistics.NumFreeSets += static_cast<uint32_t>(descriptorSetLayout.second.FreeSets.size());
+  }
+
+  return statistics;
+}
+
 BindingInput::BindingInput(Renderer::GenericBuffer& buffer, uint32_t bind)
     : Bind(bind), Input(&buffer)
 
@@ -259,3 +396,37 @@ void Bind(const Device& device,
 
 }  // namespace Renderer
 }  // namespace Vortex
+
+namespace std
+{
+std::size_t hash<Vortex::Renderer::ShaderLayout>::operator()(
+    const Vortex::Renderer::ShaderLayout& layout) const
+{
+  using Vortex::Renderer::HashCombine;
+
+  std::size_t seed = 0;
+  HashCombine(seed, static_cast<VkShaderStageFlags>(layout.shaderStage));
+  for (auto& binding : layout.bindings)
+  {
+    HashCombine(seed, binding.first);
+    HashCombine(seed, static_cast<int>(binding.second));
+  }
+  HashCombine(seed, layout.pushConstantSize);
+
+  return seed;
+}
+
+std::size_t hash<Vortex::Renderer::PipelineLayout>::operator()(
+    const Vortex::Renderer::PipelineLayout& layout) const
+{
+  using Vortex::Renderer::HashCombine;
+
+  std::size_t seed = 0;
+  for (auto& shaderLayout : layout.layouts)
+  {
+    HashCombine(seed, shaderLayout);
+  }
+
+  return seed;
+}
+}  // namespace std
@@ -11,6 +11,8 @@
 
 #include <Vortex/Utils/mapbox/variant.hpp>
 #include <map>
+#include <unordered_map>
+#include <vector>
 
 namespace Vortex
 {
@@ -48,28 +50,86 @@ struct PipelineLayout
 
 bool operator==(const PipelineLayout& left, const PipelineLayout& right);
 
+}  // namespace Renderer
+}  // namespace Vortex
+
+namespace std
+{
+template <>
+struct hash<Vortex::Renderer::ShaderLayout>
+{
+  VORTEX_API std::size_t operator()(const Vortex::Renderer::ShaderLayout& layout) const;
+};
+
+template <>
+struct hash<Vortex::Renderer::PipelineLayout>
+{
+  VORTEX_API std::size_t operator()(const Vortex::Renderer::PipelineLayout& layout) const;
+};
+}  // namespace std
+
+namespace Vortex
+{
+namespace Renderer
+{
+/**
+ * @brief A descriptor set allocated by the @ref LayoutManager. When destroyed,
+ * it is kept and re-used for the next descriptor set with the same layout.
+ */
+class PooledDescriptorSet
+{
+public:
+  VORTEX_API PooledDescriptorSet();
+  VORTEX_API ~PooledDescriptorSet();
+
+  VORTEX_API PooledDescriptorSet(PooledDescriptorSet&& other);
+  VORTEX_API PooledDescriptorSet& operator=(PooledDescriptorSet&& other);
+
+  vk::DescriptorSet operator*() const { return mDescriptorSet; }
+
+  friend class LayoutManager;
+
+private:
+  PooledDescriptorSet(vk::DescriptorSet descriptorSet, std::vector<vk::DescriptorSet>& freeSets);
+
+  vk::DescriptorSet mDescriptorSet;
+  std::vector<vk::DescriptorSet>* mFreeSets;
+};
+
 /**
  * @brief The binding of an object for a shader.
  */
 struct DescriptorSet
 {
-  vk::UniqueDescriptorSet descriptorSet;
+  PooledDescriptorSet descriptorSet;
   vk::PipelineLayout pipelineLayout;
   vk::DescriptorSetLayout descriptorSetLayout;
 };
 
 /**
- * @brief Caches and creates layouts and bindings
+ * @brief Caches and creates layouts and bindings. Descriptor sets are allocated
+ * from a chain of descriptor pools, a new pool is created when the previous
+ * one is full.
  */
 class LayoutManager
 {
 public:
+  /**
+   * @brief Usage of the descriptor pools
+   */
+  struct Statistics
+  {
+    uint32_t NumPools;
+    uint32_t NumAllocatedSets;
+    uint32_t NumFreeSets;
+  };
+
   LayoutManager(const Device& device);
 
   /**
-   * @brief Create or re-create the descriptor pool, will render invalid
-   * existing descriptor sets
-   * @param size size of the pool
+   * @brief Create or re-create the descriptor pools. Throws if descriptor sets
+   * allocated from the existing pools are still in use.
+   * @param size number of sets, and of descriptors of each type, in one pool
    */
   void CreateDescriptorPool(int size = 512);
 
@@ -95,11 +155,38 @@ public:
    */
   VORTEX_API vk::PipelineLayout GetPipelineLayout(const PipelineLayout& layout);
 
+  /**
+   * @brief Number of descriptor pools, of descriptor sets allocated from them
+   * and of sets waiting to be re-used.
+   * @return the statistics
+   */
+  VORTEX_API Statistics GetStatistics() const;
+
 private:
+  struct DescriptorPool
+  {
+    vk::UniqueDescriptorPool Pool;
+    uint32_t FreeSets;
+    std::map<vk::DescriptorType, uint32_t> FreeDescriptors;
+  };
+
+  struct DescriptorSetLayoutCache
+  {
+    vk::UniqueDescriptorSetLayout Layout;
+    std::map<vk::DescriptorType, uint32_t> Descriptors;
+    std::vector<vk::DescriptorSet> FreeSets;
+  };
+
+  DescriptorSetLayoutCache& GetDescriptorSetLayoutCache(const PipelineLayout& layout);
+  bool CanAllocate(const DescriptorPool& pool, const DescriptorSetLayoutCache& layout) const;
+  void AddDescriptorPool();
+
   const Device& mDevice;
-  vk::UniqueDescriptorPool mDescriptorPool;
-  std::vector<std::tuple<PipelineLayout, vk::UniqueDescriptorSetLayout>> mDescriptorSetLayouts;
-  std::vector<std::tuple<PipelineLayout, vk::UniquePipelineLayout>> mPipelineLayouts;
+  uint32_t mPoolSize;
+  uint32_t mNumAllocatedSets;
+  std::vector<DescriptorPool> mDescriptorPools;
+  std::unordered_map<PipelineLayout, DescriptorSetLayoutCache> mDescriptorSetLayouts;
+  std::unordered_map<PipelineLayout, vk::UniquePipelineLayout> mPipelineLayouts;
 };
 
 /**
@@ -5,10 +5,12 @@
 
 #include "Device.h"
 
+#include <algorithm>
 #include <fstream>
 #include <iostream>
 
 #include <Vortex/Renderer/Instance.h>
+#include <Vortex/Renderer/Profiler.h>
 
 #define VMA_IMPLEMENTATION
 #include <Vortex/Utils/vk_mem_alloc.h>
@@ -52,31 +54,85 @@ void DynamicDispatcher::vkCmdDebugMarkerBeginEXT(
   {
     mVkCmdDebugMarkerBeginEXT(commandBuffer, pMarkerInfo);
   }
+
+  if (mProfiler != nullptr)
+  {
+    mProfiler->BeginScope(vk::CommandBuffer(commandBuffer), pMarkerInfo->pMarkerName);
+  }
 }
 
 void DynamicDispatcher::vkCmdDebugMarkerEndEXT(VkCommandBuffer commandBuffer) const
 {
+  if (mProfiler != nullptr)
+  {
+    mProfiler->EndScope(vk::CommandBuffer(commandBuffer));
+  }
+
   if (mVkCmdDebugMarkerEndEXT != nullptr)
   {
     mVkCmdDebugMarkerEndEXT(commandBuffer);
   }
 }
 
-Device::Device(const Instance& instance, bool validation)
-    : Device(instance, ComputeFamilyIndex(instance.GetPhysicalDevice()), false, validation)
+VkResult DynamicDispatcher::vkBeginCommandBuffer(VkCommandBuffer commandBuffer,
+                                                 const VkCommandBufferBeginInfo* pBeginInfo) const
+{
+  if (mProfiler != nullptr)
+  {
+    mProfiler->BeginCommandBuffer(vk::CommandBuffer(commandBuffer));
+  }
+
+  return ::vkBeginCommandBuffer(commandBuffer, pBeginInfo);
+}
+
+void DynamicDispatcher::vkFreeCommandBuffers(VkDevice device,
+                                             VkCommandPool commandPool,
+                                             uint32_t commandBufferCount,
+                                             const VkCommandBuffer* pCommandBuffers) const
+{
+  if (mProfiler != nullptr)
+  {
+    for (uint32_t i = 0; i < commandBufferCount; i++)
+    {
+      mProfiler->FreeCommandBuffer(vk::CommandBuffer(pCommandBuffers[i]));
+    }
+  }
+
+  ::vkFreeCommandBuffers(device, commandPool, commandBufferCount, pCommandBuffers);
+}
+
+Device::Device(const Instance& instance, bool validation, const std::string& pipelineCachePath)
+    : Device(instance,
+             ComputeFamilyIndex(instance.GetPhysicalDevice()),
+             false,
+             validation,
+             pipelineCachePath)
 {
 }
 
-Device::Device(const Instance& instance, vk::SurfaceKHR surface, bool validation)
-    : Device(instance, ComputeFamilyIndex(instance.GetPhysicalDevice(), surface), true, validation)
+Device::Device(const Instance& instance,
+               vk::SurfaceKHR surface,
+               bool validation,
+               const std::string& pipelineCachePath)
+    : Device(instance,
+             ComputeFamilyIndex(instance.GetPhysicalDevice(), surface),
+             true,
+             validation,
+             pipelineCachePath)
 {
 }
 
-Device::Device(const Instance& instance, int familyIndex, bool surface, bool validation)
+Device::Device(const Instance& instance,
+               int familyIndex,
+               bool surface,
+               bool validation,
+               const std::string& pipelineCachePath)
     : mPhysicalDevice(instance.GetPhysicalDevice())
     , mFamilyIndex(familyIndex)
+    , mSubgroupArithmetic(false)
     , mLayoutManager(*this)
     , mPipelineCache(*this)
+    , mLocalSizeTuner(*this)
 {
   float queuePriority = 1.0f;
   auto deviceQueueInfo = vk::DeviceQueueCreateInfo()
@@ -123,6 +179,18 @@ Device::Device(const Instance& instance, int familyIndex, bool surface, bool val
   mDevice = mPhysicalDevice.createDeviceUnique(deviceInfo);
   mQueue = mDevice->getQueue(familyIndex, 0);
 
+  // subgroup operations in compute shaders require vulkan 1.1
+  auto apiVersion = std::min(instance.GetApiVersion(), mPhysicalDevice.getProperties().apiVersion);
+  if (apiVersion >= VK_MAKE_VERSION(1, 1, 0))
+  {
+    auto properties = mPhysicalDevice.getProperties2<vk::PhysicalDeviceProperties2,
+                                                     vk::PhysicalDeviceSubgroupProperties>();
+    auto& subgroupProperties = properties.get<vk::PhysicalDeviceSubgroupProperties>();
+    mSubgroupArithmetic =
+        (subgroupProperties.supportedStages & vk::ShaderStageFlagBits::eCompute) &&
+        (subgroupProperties.supportedOperations & vk::SubgroupFeatureFlagBits::eArithmetic);
+  }
+
   // load marker ext
   if (HasExtension(VK_EXT_DEBUG_MARKER_EXTENSION_NAME, availableExtensions))
   {
@@ -150,12 +218,14 @@ Device::Device(const Instance& instance, int familyIndex, bool surface, bool val
 
   // create objects depending on device
   mLayoutManager.CreateDescriptorPool();
-  mPipelineCache.CreateCache();
+  mPipelineCache.CreateCache(pipelineCachePath);
   mCommandBuffer = std::make_unique<CommandBuffer>(*this, true);
 }
 
 Device::~Device()
 {
+  mPipelineCache.Save();
+  mLocalSizeTuner.Save();
   vmaDestroyAllocator(mAllocator);
 }
 
@@ -184,6 +254,11 @@ PipelineCache& Device::GetPipelineCache() const
   return mPipelineCache;
 }
 
+LocalSizeTuner& Device::GetLocalSizeTuner() const
+{
+  return mLocalSizeTuner;
+}
+
 vk::PhysicalDevice Device::GetPhysicalDevice() const
 {
   return mPhysicalDevice;
@@ -194,6 +269,21 @@ int Device::GetFamilyIndex() const
   return mFamilyIndex;
 }
 
+bool Device::HasSubgroupArithmetic() const
+{
+  return mSubgroupArithmetic;
+}
+
+void Device::SetProfiler(Profiler* profiler) const
+{
+  mLoader.mProfiler = profiler;
+}
+
+Profiler* Device::GetProfiler() const
+{
+  return mLoader.mProfiler;
+}
+
 vk::CommandBuffer Device::CreateCommandBuffer() const
 {
   auto commandBufferInfo = vk::CommandBufferAllocateInfo()
@@ -206,12 +296,18 @@ vk::CommandBuffer Device::CreateCommandBuffer() const
 
 void Device::FreeCommandBuffer(vk::CommandBuffer commandBuffer) const
 {
-  mDevice->freeCommandBuffers(*mCommandPool, {commandBuffer});
+  mDevice->freeCommandBuffers(*mCommandPool, {commandBuffer}, mLoader);
 }
 
 void Device::Execute(CommandBuffer::CommandFn commandFn) const
 {
+  auto start = Profiler::Clock::now();
   (*mCommandBuffer).Record(commandFn).Submit().Wait();
+
+  if (mLoader.mProfiler != nullptr)
+  {
+    mLoader.mProfiler->AddEvent("Execute", start);
+  }
 }
 
 VmaAllocator Device::Allocator() const
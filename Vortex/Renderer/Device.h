@@ -9,9 +9,11 @@
 #include <Vortex/Renderer/Common.h>
 #include <Vortex/Renderer/DescriptorSet.h>
 #include <Vortex/Renderer/Instance.h>
+#include <Vortex/Renderer/LocalSizeTuner.h>
 #include <Vortex/Renderer/Pipeline.h>
 #include <Vortex/Utils/vk_mem_alloc.h>
 #include <map>
+#include <string>
 
 namespace Vortex
 {
@@ -39,17 +41,27 @@ private:
   std::size_t mSize;
 };
 
+class Profiler;
+
 /**
  * @brief A vulkan dynamic dispatcher that checks if the function is not null.
+ * It also notifies the attached @ref Profiler of the debug marker scopes.
  */
 struct DynamicDispatcher
 {
   void vkCmdDebugMarkerBeginEXT(VkCommandBuffer commandBuffer,
                                 const VkDebugMarkerMarkerInfoEXT* pMarkerInfo) const;
   void vkCmdDebugMarkerEndEXT(VkCommandBuffer commandBuffer) const;
+  VkResult vkBeginCommandBuffer(VkCommandBuffer commandBuffer,
+                                const VkCommandBufferBeginInfo* pBeginInfo) const;
+  void vkFreeCommandBuffers(VkDevice device,
+                            VkCommandPool commandPool,
+                            uint32_t commandBufferCount,
+                            const VkCommandBuffer* pCommandBuffers) const;
 
   PFN_vkCmdDebugMarkerBeginEXT mVkCmdDebugMarkerBeginEXT = nullptr;
   PFN_vkCmdDebugMarkerEndEXT mVkCmdDebugMarkerEndEXT = nullptr;
+  mutable Profiler* mProfiler = nullptr;
 };
 
 /**
@@ -59,9 +71,25 @@ struct DynamicDispatcher
 class Device
 {
 public:
-  VORTEX_API Device(const Instance& instance, bool validation = true);
-  VORTEX_API Device(const Instance& instance, vk::SurfaceKHR surface, bool validation = true);
-  VORTEX_API Device(const Instance& instance, int familyIndex, bool surface, bool validation);
+  /**
+   * @brief Create the device. The pipeline cache can be loaded from a file,
+   * and is then saved back to it when the device is destroyed.
+   * @param instance vulkan instance
+   * @param validation enable the validation layers and debug markers
+   * @param pipelineCachePath file of the pipeline cache, can be empty
+   */
+  VORTEX_API Device(const Instance& instance,
+                    bool validation = true,
+                    const std::string& pipelineCachePath = "");
+  VORTEX_API Device(const Instance& instance,
+                    vk::SurfaceKHR surface,
+                    bool validation = true,
+                    const std::string& pipelineCachePath = "");
+  VORTEX_API Device(const Instance& instance,
+                    int familyIndex,
+                    bool surface,
+                    bool validation,
+                    const std::string& pipelineCachePath = "");
   VORTEX_API ~Device();
 
   Device(Device&&) = delete;
@@ -73,6 +101,19 @@ public:
   VORTEX_API const DynamicDispatcher& Loader() const;
   VORTEX_API vk::PhysicalDevice GetPhysicalDevice() const;
   VORTEX_API int GetFamilyIndex() const;
+  VORTEX_API bool HasSubgroupArithmetic() const;
+
+  /**
+   * @brief Attach a profiler, which is notified of the recorded debug marker
+   * scopes. Done by the @ref Profiler itself.
+   * @param profiler the profiler, or null to detach it
+   */
+  VORTEX_API void SetProfiler(Profiler* profiler) const;
+
+  /**
+   * @brief The attached profiler, or null if there is none.
+   */
+  VORTEX_API Profiler* GetProfiler() const;
 
   // Command buffer functions
   VORTEX_API vk::CommandBuffer CreateCommandBuffer() const;
@@ -83,22 +124,24 @@ public:
   VORTEX_API VmaAllocator Allocator() const;
   VORTEX_API LayoutManager& GetLayoutManager() const;
   VORTEX_API PipelineCache& GetPipelineCache() const;
+  VORTEX_API LocalSizeTuner& GetLocalSizeTuner() const;
   VORTEX_API vk::ShaderModule GetShaderModule(const SpirvBinary& spirv) const;
 
 private:
   vk::PhysicalDevice mPhysicalDevice;
   DynamicDispatcher mLoader;
   int mFamilyIndex;
+  bool mSubgroupArithmetic;
   vk::UniqueDevice mDevice;
   vk::Queue mQueue;
   vk::UniqueCommandPool mCommandPool;
-  vk::UniqueDescriptorPool mDescriptorPool;
   VmaAllocator mAllocator;
 
   mutable std::unique_ptr<CommandBuffer> mCommandBuffer;
   mutable std::map<const uint32_t*, vk::UniqueShaderModule> mShaders;
   mutable LayoutManager mLayoutManager;
   mutable PipelineCache mPipelineCache;
+  mutable LocalSizeTuner mLocalSizeTuner;
 };
 
 }  // namespace Renderer
@@ -79,6 +79,8 @@ Instance::Instance(const std::string& name,
     mInstance = vk::createInstanceUnique(instanceInfo);
   }
 
+  mApiVersion = appInfo.apiVersion;
+
   // init dynamic loader
   mLoader.init(*mInstance, vkGetInstanceProcAddr, VK_NULL_HANDLE, nullptr);
 
@@ -124,6 +126,11 @@ vk::Instance Instance::GetInstance() const
   return *mInstance;
 }
 
+uint32_t Instance::GetApiVersion() const
+{
+  return mApiVersion;
+}
+
 bool HasLayer(const char* extension, const std::vector<vk::LayerProperties>& availableExtensions)
 {
   return std::any_of(availableExtensions.begin(),
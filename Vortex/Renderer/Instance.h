@@ -29,12 +29,14 @@ public:
 
   VORTEX_API vk::PhysicalDevice GetPhysicalDevice() const;
   VORTEX_API vk::Instance GetInstance() const;
+  VORTEX_API uint32_t GetApiVersion() const;
 
 private:
   vk::UniqueInstance mInstance;
   vk::DispatchLoaderDynamic mLoader;
   vk::PhysicalDevice mPhysicalDevice;
   vk::DebugReportCallbackEXT mDebugCallback;
+  uint32_t mApiVersion;
 };
 
 bool HasLayer(const char* extension, const std::vector<vk::LayerProperties>& availableExtensions);
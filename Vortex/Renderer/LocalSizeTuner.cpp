@@ -0,0 +1,245 @@
+//
+//  LocalSizeTuner.cpp
+//  Vortex
+//
+
+#include "LocalSizeTuner.h"
+
+#include <Vortex/Renderer/CommandBuffer.h>
+#include <Vortex/Renderer/Device.h>
+#include <Vortex/Renderer/Timer.h>
+#include <Vortex/Renderer/Work.h>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+
+namespace Vortex
+{
+namespace Renderer
+{
+namespace
+{
+const char* FileVersion = "vortex2d-local-sizes 1";
+
+// each candidate is run several times and the fastest run is kept, the first
+// one also warms up the caches.
+const int Repetitions = 3;
+
+const std::vector<glm::ivec2> Candidates = {
+    {64, 4}, {32, 8}, {16, 16}, {8, 8}, {16, 8}, {32, 4}, {128, 2}, {8, 32}};
+
+bool IsValid(const vk::PhysicalDeviceLimits& limits,
+             const ComputeSize& computeSize,
+             const glm::ivec2& localSize)
+{
+  if (static_cast<uint32_t>(localSize.x * localSize.y) > limits.maxComputeWorkGroupInvocations ||
+      static_cast<uint32_t>(localSize.x) > limits.maxComputeWorkGroupSize[0] ||
+      static_cast<uint32_t>(localSize.y) > limits.maxComputeWorkGroupSize[1])
+  {
+    return false;
+  }
+
+  // the stencil is loaded in the local memory, the inner part must not be empty
+  if (computeSize.WorkShape == ComputeSize::Shape::Stencil)
+  {
+    return glm::all(glm::greaterThan(localSize, glm::ivec2(2 * computeSize.StencilRadius)));
+  }
+
+  return true;
+}
+}  // namespace
+
+LocalSizeTuner::LocalSizeTuner(const Device& device) : mDevice(device), mTuning(false) {}
+
+void LocalSizeTuner::Load(const std::string& path)
+{
+  mPath = path;
+  mLocalSizes.clear();
+
+  std::ifstream file(path);
+  if (!file)
+  {
+    return;
+  }
+
+  std::string version, identifier;
+  if (!std::getline(file, version) || version != FileVersion || !std::getline(file, identifier) ||
+      identifier != DeviceIdentifier())
+  {
+    return;
+  }
+
+  Key key;
+  glm::ivec2 localSize;
+  while (file >> std::hex >> key.Shader >> std::dec >> key.Shape >> key.StencilRadius >>
+         key.DomainX >> key.DomainY >> localSize.x >> localSize.y)
+  {
+    mLocalSizes[key] = localSize;
+  }
+}
+
+void LocalSizeTuner::Save() const
+{
+  if (mPath.empty())
+  {
+    return;
+  }
+
+  std::ofstream file(mPath, std::ios::trunc);
+  file << FileVersion << "\n" << DeviceIdentifier() << "\n";
+  for (auto& localSize : mLocalSizes)
+  {
+    auto& key = localSize.first;
+    file << std::hex << key.Shader << std::dec << " " << key.Shape << " " << key.StencilRadius
+         << " " << key.DomainX << " " << key.DomainY << " " << localSize.second.x << " "
+         << localSize.second.y << "\n";
+  }
+}
+
+void LocalSizeTuner::SetTuning(bool tuning)
+{
+  mTuning = tuning;
+}
+
+bool LocalSizeTuner::IsTuning() const
+{
+  return mTuning;
+}
+
+bool LocalSizeTuner::Find(uint64_t shader,
+                          const ComputeSize& computeSize,
+                          glm::ivec2& localSize) const
+{
+  auto it = mLocalSizes.find(MakeKey(shader, computeSize));
+  if (it == mLocalSizes.end())
+  {
+    return false;
+  }
+
+  localSize = it->second;
+  return true;
+}
+
+glm::ivec2 LocalSizeTuner::Tune(uint64_t shader,
+                                const ComputeSize& computeSize,
+                                vk::ShaderModule shaderModule,
+                                vk::PipelineLayout layout,
+                                const SpecConstInfo& specConstInfo,
+                                uint32_t pushConstantSize,
+                                vk::DescriptorSet descriptorSet)
+{
+  auto limits = mDevice.GetPhysicalDevice().getProperties().limits;
+  if (!limits.timestampComputeAndGraphics)
+  {
+    return computeSize.LocalSize;
+  }
+
+  // the other push constants are zero, the domain size is set as in Work::Bound::Record
+  std::vector<uint8_t> pushConstants(pushConstantSize, 0);
+  std::memcpy(pushConstants.data(),
+              &computeSize.DomainSize,
+              std::min<std::size_t>(pushConstantSize, computeSize.DomainSize.y != 1 ? 8 : 4));
+
+  Timer timer(mDevice);
+  CommandBuffer run(mDevice);
+
+  glm::ivec2 bestLocalSize = computeSize.LocalSize;
+  uint64_t bestTime = std::numeric_limits<uint64_t>::max();
+  for (auto& localSize : Candidates)
+  {
+    if (!IsValid(limits, computeSize, localSize))
+    {
+      continue;
+    }
+
+    auto candidateSize = computeSize.WithLocalSize(localSize);
+    SpecConstInfo candidateSpecConstInfo = specConstInfo;
+    Detail::InsertSpecConst(
+        candidateSpecConstInfo, SpecConstValue(1, localSize.x), SpecConstValue(2, localSize.y));
+
+    auto pipeline = mDevice.GetPipelineCache().CreateComputePipeline(
+        shaderModule, layout, candidateSpecConstInfo);
+
+    run.Record([&](vk::CommandBuffer commandBuffer) {
+      if (pushConstantSize > 0)
+      {
+        commandBuffer.pushConstants(layout,
+                                    vk::ShaderStageFlagBits::eCompute,
+                                    0,
+                                    pushConstantSize,
+                                    pushConstants.data());
+      }
+
+      commandBuffer.bindDescriptorSets(
+          vk::PipelineBindPoint::eCompute, layout, 0, {descriptorSet}, {});
+      commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, pipeline);
+
+      timer.Start(commandBuffer);
+      commandBuffer.dispatch(candidateSize.WorkSize.x, candidateSize.WorkSize.y, 1);
+      timer.Stop(commandBuffer);
+    });
+
+    uint64_t time = std::numeric_limits<uint64_t>::max();
+    for (int i = 0; i < Repetitions; i++)
+    {
+      run.Submit().Wait();
+      time = std::min(time, timer.GetElapsedNs());
+    }
+
+    if (time < bestTime)
+    {
+      bestTime = time;
+      bestLocalSize = localSize;
+    }
+  }
+
+  mLocalSizes[MakeKey(shader, computeSize)] = bestLocalSize;
+  return bestLocalSize;
+}
+
+LocalSizeTuner::Key LocalSizeTuner::MakeKey(uint64_t shader, const ComputeSize& computeSize)
+{
+  return {shader,
+          static_cast<int>(computeSize.WorkShape),
+          computeSize.StencilRadius,
+          computeSize.DomainSize.x,
+          computeSize.DomainSize.y};
+}
+
+std::string LocalSizeTuner::DeviceIdentifier() const
+{
+  auto properties = mDevice.GetPhysicalDevice().getProperties();
+
+  std::ostringstream identifier;
+  identifier << std::hex << properties.vendorID << " " << properties.deviceID << " "
+             << properties.driverVersion << " ";
+  for (auto byte : properties.pipelineCacheUUID)
+  {
+    identifier << std::setw(2) << std::setfill('0') << static_cast<int>(byte);
+  }
+
+  return identifier.str();
+}
+
+uint64_t HashSpirv(const uint32_t* data, std::size_t words)
+{
+  // FNV-1a, which unlike std::hash is the same on every run and platform
+  uint64_t hash = 14695981039346656037ull;
+  for (std::size_t i = 0; i < words; i++)
+  {
+    for (int byte = 0; byte < 4; byte++)
+    {
+      hash ^= (data[i] >> (8 * byte)) & 0xFF;
+      hash *= 1099511628211ull;
+    }
+  }
+
+  return hash;
+}
+
+}  // namespace Renderer
+}  // namespace Vortex
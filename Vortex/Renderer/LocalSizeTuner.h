@@ -0,0 +1,124 @@
+//
+//  LocalSizeTuner.h
+//  Vortex
+//
+
+#pragma once
+
+#include <Vortex/Renderer/Common.h>
+
+#include <map>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace Vortex
+{
+namespace Renderer
+{
+class Device;
+struct ComputeSize;
+struct SpecConstInfo;
+
+/**
+ * @brief Finds the fastest local size of compute shaders for a device. The
+ * local size is tuned per shader and domain size, by timing the candidate
+ * local sizes with the specialization constants. The results can be saved to
+ * a file and are then used when creating @ref Work.
+ */
+class LocalSizeTuner
+{
+public:
+  LocalSizeTuner(const Device& device);
+
+  /**
+   * @brief Load the tuned local sizes from a file, which they are also saved
+   * to. The file is ignored if it was created by a different device or driver
+   * version.
+   * @param path file of the tuned local sizes
+   */
+  VORTEX_API void Load(const std::string& path);
+
+  /**
+   * @brief Save the tuned local sizes to the file given when loading. Does
+   * nothing if no file was given. Called when the device is destroyed.
+   */
+  VORTEX_API void Save() const;
+
+  /**
+   * @brief Enable tuning the shaders which don't have a tuned local size yet.
+   * The shaders are tuned when first bound, by running them on the bound
+   * buffers and textures, which are then overwritten. This is meant for a
+   * dedicated tuning run, whose results are saved.
+   * @param tuning enable or disable tuning
+   */
+  VORTEX_API void SetTuning(bool tuning);
+
+  /**
+   * @brief If shaders without a tuned local size are tuned.
+   */
+  bool IsTuning() const;
+
+  /**
+   * @brief Find the tuned local size of a shader.
+   * @param shader hash of the spirv binary
+   * @param computeSize the compute size of the shader
+   * @param localSize the tuned local size, if found
+   * @return if a tuned local size was found
+   */
+  bool Find(uint64_t shader, const ComputeSize& computeSize, glm::ivec2& localSize) const;
+
+  /**
+   * @brief Time the candidate local sizes of a shader and keep the fastest.
+   * @param shader hash of the spirv binary
+   * @param computeSize the compute size of the shader
+   * @param shaderModule the shader
+   * @param layout pipeline layout of the shader
+   * @param specConstInfo additional specialization constants
+   * @param pushConstantSize size of the push constants
+   * @param descriptorSet descriptor set bound when running the shader
+   * @return the fastest local size
+   */
+  glm::ivec2 Tune(uint64_t shader,
+                  const ComputeSize& computeSize,
+                  vk::ShaderModule shaderModule,
+                  vk::PipelineLayout layout,
+                  const SpecConstInfo& specConstInfo,
+                  uint32_t pushConstantSize,
+                  vk::DescriptorSet descriptorSet);
+
+private:
+  struct Key
+  {
+    uint64_t Shader;
+    int Shape;
+    int StencilRadius;
+    int DomainX;
+    int DomainY;
+
+    friend bool operator<(const Key& left, const Key& right)
+    {
+      return std::tie(left.Shader, left.Shape, left.StencilRadius, left.DomainX, left.DomainY) <
+             std::tie(right.Shader, right.Shape, right.StencilRadius, right.DomainX, right.DomainY);
+    }
+  };
+
+  static Key MakeKey(uint64_t shader, const ComputeSize& computeSize);
+  std::string DeviceIdentifier() const;
+
+  const Device& mDevice;
+  std::string mPath;
+  bool mTuning;
+  std::map<Key, glm::ivec2> mLocalSizes;
+};
+
+/**
+ * @brief Hash of a spirv binary, which is the same between runs.
+ * @param data spirv words
+ * @param words number of words
+ * @return the hash
+ */
+uint64_t HashSpirv(const uint32_t* data, std::size_t words);
+
+}  // namespace Renderer
+}  // namespace Vortex
@@ -0,0 +1,227 @@
+//
+//  PassGraph.cpp
+//  Vortex
+//
+
+#include "PassGraph.h"
+
+#include <Vortex/Renderer/Buffer.h>
+#include <Vortex/Renderer/PipelineBarrier.h>
+#include <Vortex/Renderer/Texture.h>
+
+#include <algorithm>
+
+namespace Vortex
+{
+namespace Renderer
+{
+namespace
+{
+bool Contains(const PassGraph::ResourceList& resources, const PassResource& resource)
+{
+  return std::find(resources.begin(), resources.end(), resource) != resources.end();
+}
+
+bool Intersects(const PassGraph::ResourceList& left, const PassGraph::ResourceList& right)
+{
+  return std::any_of(left.begin(), left.end(), [&](const PassResource& resource) {
+    return Contains(right, resource);
+  });
+}
+
+void AddUnique(PassGraph::ResourceList& resources, const PassResource& resource)
+{
+  if (!Contains(resources, resource))
+  {
+    resources.push_back(resource);
+  }
+}
+
+void Add(PipelineBarrier& barrier, const PassResource& resource)
+{
+  vk::AccessFlags newAccess = vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite;
+  if (resource.Buffer != nullptr)
+  {
+    barrier.Add(*resource.Buffer, vk::AccessFlagBits::eShaderWrite, newAccess);
+  }
+  else
+  {
+    barrier.Add(*resource.Texture,
+                vk::ImageLayout::eGeneral,
+                vk::AccessFlagBits::eShaderWrite,
+                vk::ImageLayout::eGeneral,
+                newAccess);
+  }
+}
+}  // namespace
+
+PassResource::PassResource(Renderer::GenericBuffer& buffer) : Buffer(&buffer), Texture(nullptr) {}
+
+PassResource::PassResource(Renderer::Texture& texture) : Buffer(nullptr), Texture(&texture) {}
+
+bool operator==(const PassResource& left, const PassResource& right)
+{
+  return left.Buffer == right.Buffer && left.Texture == right.Texture;
+}
+
+PassGraph::PassGraph() : mDirty(false) {}
+
+void PassGraph::AddPass(const std::string& name,
+                        const ResourceList& reads,
+                        const ResourceList& writes,
+                        CommandBuffer::CommandFn pass)
+{
+  mPasses.push_back({name, reads, writes, pass});
+  mDirty = true;
+}
+
+void PassGraph::Clear()
+{
+  mPasses.clear();
+  mSchedule.clear();
+  mDirty = false;
+}
+
+void PassGraph::Compile()
+{
+  mSchedule.clear();
+
+  // each pass is placed in the region following the last pass it conflicts
+  // with: read after write, write after read or write after write.
+  std::vector<std::size_t> regions(mPasses.size());
+  for (std::size_t i = 0; i < mPasses.size(); i++)
+  {
+    std::size_t region = 0;
+    for (std::size_t j = 0; j < i; j++)
+    {
+      if (Intersects(mPasses[i].Reads, mPasses[j].Writes) ||
+          Intersects(mPasses[i].Writes, mPasses[j].Reads) ||
+          Intersects(mPasses[i].Writes, mPasses[j].Writes))
+      {
+        region = std::max(region, regions[j] + 1);
+      }
+    }
+
+    regions[i] = region;
+    if (region >= mSchedule.size())
+    {
+      mSchedule.resize(region + 1);
+    }
+    mSchedule[region].Passes.push_back(i);
+  }
+
+  // only the writes not yet synchronised and used by the region need a barrier
+  ResourceList pendingWrites;
+  for (auto& region : mSchedule)
+  {
+    auto addBarriers = [&](const ResourceList& resources) {
+      for (auto& resource : resources)
+      {
+        if (Contains(pendingWrites, resource))
+        {
+          AddUnique(region.Barriers, resource);
+        }
+      }
+    };
+
+    for (auto pass : region.Passes)
+    {
+      addBarriers(mPasses[pass].Reads);
+      addBarriers(mPasses[pass].Writes);
+    }
+
+    pendingWrites.erase(std::remove_if(pendingWrites.begin(),
+                                       pendingWrites.end(),
+                                       [&](const PassResource& resource) {
+                                         return Contains(region.Barriers, resource);
+                                       }),
+                        pendingWrites.end());
+
+    for (auto pass : region.Passes)
+    {
+      for (auto& resource : mPasses[pass].Writes)
+      {
+        AddUnique(pendingWrites, resource);
+      }
+    }
+  }
+
+  if (!mPasses.empty())
+  {
+    mSchedule.push_back({{}, pendingWrites});
+  }
+
+  mDirty = false;
+}
+
+void PassGraph::Record(vk::CommandBuffer commandBuffer)
+{
+  if (mDirty)
+  {
+    Compile();
+  }
+
+  for (std::size_t i = 0; i < mSchedule.size(); i++)
+  {
+    auto& region = mSchedule[i];
+    bool last = i + 1 == mSchedule.size();
+
+    PipelineBarrier barrier(
+        vk::PipelineStageFlagBits::eComputeShader,
+        last ? vk::PipelineStageFlagBits::eAllCommands : vk::PipelineStageFlagBits::eComputeShader);
+    for (auto& resource : region.Barriers)
+    {
+      Add(barrier, resource);
+    }
+
+    if (i > 0 && !last && region.Barriers.empty())
+    {
+      // write after read only needs an execution dependency
+      commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader,
+                                    vk::PipelineStageFlagBits::eComputeShader,
+                                    {},
+                                    nullptr,
+                                    nullptr,
+                                    nullptr);
+    }
+    else
+    {
+      barrier.Record(commandBuffer);
+    }
+
+    for (auto pass : region.Passes)
+    {
+      mPasses[pass].Fn(commandBuffer);
+    }
+  }
+}
+
+const std::vector<PassGraph::Region>& PassGraph::GetSchedule()
+{
+  if (mDirty)
+  {
+    Compile();
+  }
+
+  return mSchedule;
+}
+
+const std::string& PassGraph::GetName(std::size_t pass) const
+{
+  assert(pass < mPasses.size());
+  return mPasses[pass].Name;
+}
+
+std::size_t PassGraph::GetBarrierCount()
+{
+  std::size_t count = 0;
+  for (auto& region : GetSchedule())
+  {
+    count += region.Barriers.size();
+  }
+
+  return count;
+}
+
+}  // namespace Renderer
+}  // namespace Vortex
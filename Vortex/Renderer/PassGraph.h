@@ -0,0 +1,123 @@
+//
+//  PassGraph.h
+//  Vortex
+//
+
+#pragma once
+
+#include <Vortex/Renderer/CommandBuffer.h>
+#include <Vortex/Renderer/Common.h>
+
+#include <string>
+#include <vector>
+
+namespace Vortex
+{
+namespace Renderer
+{
+class GenericBuffer;
+class Texture;
+
+/**
+ * @brief A buffer or texture read or written by a pass of a @ref PassGraph
+ */
+struct PassResource
+{
+  VORTEX_API PassResource(Renderer::GenericBuffer& buffer);
+  VORTEX_API PassResource(Renderer::Texture& texture);
+
+  Renderer::GenericBuffer* Buffer;
+  Renderer::Texture* Texture;
+};
+
+VORTEX_API bool operator==(const PassResource& left, const PassResource& right);
+
+/**
+ * @brief A list of compute passes, each declaring the resources it reads and
+ * writes. The passes are scheduled in regions of independent passes which are
+ * recorded without barriers between them. Barriers are only inserted between
+ * regions, and only for the resources which need it.
+ *
+ * The passes are expected to record compute work. Any other command (e.g. a
+ * clear or a copy) must synchronise itself.
+ */
+class PassGraph
+{
+public:
+  using ResourceList = std::vector<PassResource>;
+
+  /**
+   * @brief A set of independent passes, recorded after the barriers on the
+   * listed resources.
+   */
+  struct Region
+  {
+    std::vector<std::size_t> Passes;
+    ResourceList Barriers;
+  };
+
+  VORTEX_API PassGraph();
+
+  /**
+   * @brief Add a pass to the graph. Passes accessing the same resources are
+   * recorded in the order they are added.
+   * @param name name of the pass, used for inspection
+   * @param reads the resources read by the pass
+   * @param writes the resources written by the pass
+   * @param pass the function recording the pass
+   */
+  VORTEX_API void AddPass(const std::string& name,
+                          const ResourceList& reads,
+                          const ResourceList& writes,
+                          CommandBuffer::CommandFn pass);
+
+  /**
+   * @brief Remove all passes
+   */
+  VORTEX_API void Clear();
+
+  /**
+   * @brief Record the passes with their barriers. The resources written are
+   * synchronised with any following command at the end.
+   * @param commandBuffer the command buffer to record into
+   */
+  VORTEX_API void Record(vk::CommandBuffer commandBuffer);
+
+  /**
+   * @brief The scheduled regions, in the order they are recorded. The last
+   * region has no passes and synchronises the remaining written resources.
+   * @return the list of regions
+   */
+  VORTEX_API const std::vector<Region>& GetSchedule();
+
+  /**
+   * @brief The name of a pass
+   * @param pass index of the pass, in the order they were added
+   * @return the name
+   */
+  VORTEX_API const std::string& GetName(std::size_t pass) const;
+
+  /**
+   * @brief The total number of resource barriers recorded by the graph
+   * @return the number of barriers
+   */
+  VORTEX_API std::size_t GetBarrierCount();
+
+private:
+  struct Pass
+  {
+    std::string Name;
+    ResourceList Reads;
+    ResourceList Writes;
+    CommandBuffer::CommandFn Fn;
+  };
+
+  void Compile();
+
+  std::vector<Pass> mPasses;
+  std::vector<Region> mSchedule;
+  bool mDirty;
+};
+
+}  // namespace Renderer
+}  // namespace Vortex
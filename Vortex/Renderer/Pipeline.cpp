@@ -6,11 +6,79 @@
 #include "Pipeline.h"
 #include <Vortex/Renderer/Device.h>
 #include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
 
 namespace Vortex
 {
 namespace Renderer
 {
+namespace
+{
+const uint32_t CacheFileMagic = 0x43505856;  // "VXPC"
+
+/**
+ * Header written in front of the vulkan pipeline cache data, the cache data is
+ * only valid for the same device and driver.
+ */
+struct CacheFileHeader
+{
+  uint32_t Magic;
+  uint32_t VendorID;
+  uint32_t DeviceID;
+  uint32_t DriverVersion;
+  uint8_t PipelineCacheUUID[VK_UUID_SIZE];
+  uint64_t DataSize;
+};
+
+CacheFileHeader MakeCacheFileHeader(vk::PhysicalDevice physicalDevice, uint64_t dataSize)
+{
+  auto properties = physicalDevice.getProperties();
+
+  CacheFileHeader header = {};
+  header.Magic = CacheFileMagic;
+  header.VendorID = properties.vendorID;
+  header.DeviceID = properties.deviceID;
+  header.DriverVersion = properties.driverVersion;
+  std::memcpy(header.PipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE);
+  header.DataSize = dataSize;
+
+  return header;
+}
+
+std::vector<char> ReadCacheFile(vk::PhysicalDevice physicalDevice, const std::string& path)
+{
+  std::ifstream file(path, std::ios::binary);
+  if (!file)
+  {
+    return {};
+  }
+
+  std::vector<char> content((std::istreambuf_iterator<char>(file)),
+                            std::istreambuf_iterator<char>());
+  if (content.size() < sizeof(CacheFileHeader))
+  {
+    return {};
+  }
+
+  CacheFileHeader header;
+  std::memcpy(&header, content.data(), sizeof(CacheFileHeader));
+
+  auto expected = MakeCacheFileHeader(physicalDevice, content.size() - sizeof(CacheFileHeader));
+  if (header.Magic != expected.Magic || header.VendorID != expected.VendorID ||
+      header.DeviceID != expected.DeviceID || header.DriverVersion != expected.DriverVersion ||
+      std::memcmp(header.PipelineCacheUUID, expected.PipelineCacheUUID, VK_UUID_SIZE) != 0 ||
+      header.DataSize != expected.DataSize)
+  {
+    return {};
+  }
+
+  return std::vector<char>(content.begin() + sizeof(CacheFileHeader), content.end());
+}
+}  // namespace
+
 GraphicsPipeline::GraphicsPipeline()
 {
   mInputAssembly =
@@ -93,26 +161,144 @@ bool operator==(const SpecConstInfo& left, const SpecConstInfo& right)
   return left.data == right.data && left.mapEntries == right.mapEntries;
 }
 
-PipelineCache::PipelineCache(const Device& device) : mDevice(device) {}
+PipelineCache::PipelineCache(const Device& device) : mDevice(device), mStop(false) {}
+
+PipelineCache::~PipelineCache()
+{
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mStop = true;
+  }
+
+  mCondition.notify_all();
+  for (auto& worker : mWorkers)
+  {
+    worker.join();
+  }
+}
 
-void PipelineCache::CreateCache()
+void PipelineCache::CreateCache(const std::string& path)
 {
-  auto info = vk::PipelineCacheCreateInfo();
+  mPath = path;
+
+  std::vector<char> data;
+  if (!mPath.empty())
+  {
+    data = ReadCacheFile(mDevice.GetPhysicalDevice(), mPath);
+  }
+
+  auto info = vk::PipelineCacheCreateInfo().setInitialDataSize(data.size()).setPInitialData(
+      data.empty() ? nullptr : data.data());
   mCache = mDevice.Handle().createPipelineCacheUnique(info);
+  mLoaded = !data.empty();
+
+  // the pipeline cache is internally synchronised, so the workers can share it
+  auto numWorkers = std::thread::hardware_concurrency();
+  for (unsigned i = 0; i < numWorkers; i++)
+  {
+    mWorkers.emplace_back(&PipelineCache::WorkerThread, this);
+  }
+}
+
+void PipelineCache::WorkerThread()
+{
+  while (true)
+  {
+    std::function<void()> task;
+
+    {
+      std::unique_lock<std::mutex> lock(mMutex);
+      mCondition.wait(lock, [&] { return mStop || !mTasks.empty(); });
+      if (mTasks.empty())
+      {
+        return;
+      }
+
+      task = std::move(mTasks.front());
+      mTasks.pop_front();
+    }
+
+    task();
+  }
+}
+
+void PipelineCache::Wait() const
+{
+  for (auto& pipeline : mComputePipelines)
+  {
+    pipeline.second.Future.wait();
+  }
+}
+
+std::size_t PipelineCache::PipelineKeyHash::operator()(const GraphicsPipelineKey& key) const
+{
+  std::size_t seed = 0;
+  HashCombine(seed, key.State);
+  HashCombine(seed, key.Graphics);
+
+  return seed;
+}
+
+std::size_t PipelineCache::PipelineKeyHash::operator()(const ComputePipelineKey& key) const
+{
+  std::size_t seed = 0;
+  HashCombine(seed, static_cast<VkShaderModule>(key.Shader));
+  HashCombine(seed, static_cast<VkPipelineLayout>(key.Layout));
+  HashCombine(seed, key.SpecConst);
+
+  return seed;
+}
+
+bool PipelineCache::Save() const noexcept
+{
+  if (mPath.empty() || !mCache)
+  {
+    return false;
+  }
+
+  try
+  {
+    Wait();
+
+    auto data = mDevice.Handle().getPipelineCacheData(*mCache);
+    auto header = MakeCacheFileHeader(mDevice.GetPhysicalDevice(), data.size());
+
+    auto tmpPath = mPath + ".tmp";
+    {
+      std::ofstream file(tmpPath, std::ios::binary | std::ios::trunc);
+      file.write(reinterpret_cast<const char*>(&header), sizeof(CacheFileHeader));
+      file.write(reinterpret_cast<const char*>(data.data()), data.size());
+      file.close();
+      if (!file)
+      {
+        std::remove(tmpPath.c_str());
+        return false;
+      }
+    }
+
+    // rename doesn't replace an existing file on every platform
+    std::remove(mPath.c_str());
+    return std::rename(tmpPath.c_str(), mPath.c_str()) == 0;
+  }
+  catch (const std::exception&)
+  {
+    return false;
+  }
+}
+
+bool PipelineCache::IsLoaded() const
+{
+  return mLoaded;
 }
 
 vk::Pipeline PipelineCache::CreateGraphicsPipeline(const GraphicsPipeline& graphics,
                                                    const RenderState& renderState)
 {
-  auto it = std::find_if(mGraphicsPipelines.begin(),
-                         mGraphicsPipelines.end(),
-                         [&](const GraphicsPipelineCache& pipeline) {
-                           return pipeline.Graphics == graphics && pipeline.State == renderState;
-                         });
-
+  GraphicsPipelineKey key = {renderState, graphics};
+  auto it = mGraphicsPipelines.find(key);
   if (it != mGraphicsPipelines.end())
   {
-    return *it->Pipeline;
+    return *it->second;
   }
 
   auto vertexInputInfo =
@@ -159,43 +345,107 @@ vk::Pipeline PipelineCache::CreateGraphicsPipeline(const GraphicsPipeline& graph
                           .setPViewportState(&viewPortState)
                           .setPDynamicState(&dynamicState);
 
-  GraphicsPipelineCache pipeline = {
-      renderState, graphics, mDevice.Handle().createGraphicsPipelineUnique(*mCache, pipelineInfo)};
-  mGraphicsPipelines.push_back(std::move(pipeline));
-  return *mGraphicsPipelines.back().Pipeline;
+  auto pipeline = mDevice.Handle().createGraphicsPipelineUnique(*mCache, pipelineInfo);
+  it = mGraphicsPipelines.emplace(std::move(key), std::move(pipeline)).first;
+  return *it->second;
 }
 
 vk::Pipeline PipelineCache::CreateComputePipeline(vk::ShaderModule shader,
                                                   vk::PipelineLayout layout,
                                                   SpecConstInfo specConstInfo)
 {
-  auto it = std::find_if(mComputePipelines.begin(),
-                         mComputePipelines.end(),
-                         [&](const ComputePipelineCache& pipeline) {
-                           return pipeline.Shader == shader && pipeline.Layout == layout &&
-                                  pipeline.SpecConst == specConstInfo;
-                         });
+  return CreateComputePipelineAsync(shader, layout, std::move(specConstInfo)).get();
+}
 
+std::shared_future<vk::Pipeline> PipelineCache::CreateComputePipelineAsync(
+    vk::ShaderModule shader,
+    vk::PipelineLayout layout,
+    SpecConstInfo specConstInfo)
+{
+  ComputePipelineKey key = {shader, layout, specConstInfo};
+  auto it = mComputePipelines.find(key);
   if (it != mComputePipelines.end())
   {
-    return *it->Pipeline;
+    return it->second.Future;
   }
 
-  auto stageInfo = vk::PipelineShaderStageCreateInfo()
-                       .setModule(shader)
-                       .setPName("main")
-                       .setStage(vk::ShaderStageFlagBits::eCompute)
-                       .setPSpecializationInfo(&specConstInfo.info);
+  // elements of an unordered_map are not moved when inserting
+  auto cache = &mComputePipelines[std::move(key)];
+  auto task = std::make_shared<std::packaged_task<vk::Pipeline()>>(
+      [this, cache, shader, layout, specConstInfo]() mutable {
+        // point the specialization info to the copied entries and data
+        Detail::InsertSpecConst(specConstInfo);
+
+        auto stageInfo = vk::PipelineShaderStageCreateInfo()
+                             .setModule(shader)
+                             .setPName("main")
+                             .setStage(vk::ShaderStageFlagBits::eCompute)
+                             .setPSpecializationInfo(&specConstInfo.info);
+
+        auto pipelineInfo = vk::ComputePipelineCreateInfo().setStage(stageInfo).setLayout(layout);
 
-  auto pipelineInfo = vk::ComputePipelineCreateInfo().setStage(stageInfo).setLayout(layout);
+        cache->Pipeline = mDevice.Handle().createComputePipelineUnique(*mCache, pipelineInfo);
+        return *cache->Pipeline;
+      });
 
-  mComputePipelines.push_back(
-      {shader,
-       layout,
-       specConstInfo,
-       mDevice.Handle().createComputePipelineUnique(*mCache, pipelineInfo)});
-  return *mComputePipelines.back().Pipeline;
+  cache->Future = task->get_future().share();
+
+  if (mWorkers.empty())
+  {
+    (*task)();
+  }
+  else
+  {
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      mTasks.emplace_back([task] { (*task)(); });
+    }
+
+    mCondition.notify_one();
+  }
+
+  return cache->Future;
 }
 
 }  // namespace Renderer
 }  // namespace Vortex
+
+namespace std
+{
+std::size_t hash<Vortex::Renderer::GraphicsPipeline>::operator()(
+    const Vortex::Renderer::GraphicsPipeline& graphics) const
+{
+  using Vortex::Renderer::HashCombine;
+
+  std::size_t seed = 0;
+  HashCombine(seed, static_cast<VkPipelineLayout>(graphics.mPipelineLayout));
+  HashCombine(seed, static_cast<int>(graphics.mInputAssembly.topology));
+  for (auto& shaderStage : graphics.mShaderStages)
+  {
+    HashCombine(seed, static_cast<VkShaderModule>(shaderStage.module));
+    HashCombine(seed, static_cast<VkShaderStageFlags>(shaderStage.stage));
+  }
+
+  return seed;
+}
+
+std::size_t hash<Vortex::Renderer::SpecConstInfo>::operator()(
+    const Vortex::Renderer::SpecConstInfo& specConstInfo) const
+{
+  using Vortex::Renderer::HashCombine;
+
+  std::size_t seed = 0;
+  for (auto& mapEntry : specConstInfo.mapEntries)
+  {
+    HashCombine(seed, mapEntry.constantID);
+    HashCombine(seed, mapEntry.offset);
+    HashCombine(seed, mapEntry.size);
+  }
+  for (auto value : specConstInfo.data)
+  {
+    HashCombine(seed, value);
+  }
+
+  return seed;
+}
+}  // namespace std
@@ -8,7 +8,15 @@
 #include <Vortex/Renderer/Common.h>
 #include <Vortex/Renderer/RenderState.h>
 
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 
 namespace Vortex
@@ -63,6 +71,7 @@ public:
   VORTEX_API GraphicsPipeline& DynamicState(vk::DynamicState dynamicState);
 
   friend class PipelineCache;
+  friend struct std::hash<GraphicsPipeline>;
   friend bool operator==(const GraphicsPipeline&, const GraphicsPipeline&);
 
 private:
@@ -143,17 +152,35 @@ inline SpecConstInfo SpecConst(Args&&... args)
 }
 
 /**
- * Create pipelines using vulkan's pipeline cache.
+ * Create pipelines using vulkan's pipeline cache. Compute pipelines are created
+ * on worker threads.
  */
 class PipelineCache
 {
 public:
   PipelineCache(const Device& device);
+  ~PipelineCache();
 
   /**
    * @brief Create the pipeline cache.
+   * @param path file to load the cache from and save it to, can be empty. The
+   * file is ignored if it was created by a different device or driver version.
    */
-  void CreateCache();
+  void CreateCache(const std::string& path);
+
+  /**
+   * @brief Save the pipeline cache to the file given when creating it. Does
+   * nothing if no file was given. Called when the device is destroyed. The
+   * cache is written to a temporary file first, so a failed write leaves the
+   * previous file untouched.
+   * @return if the cache was saved
+   */
+  VORTEX_API bool Save() const noexcept;
+
+  /**
+   * @brief If the pipeline cache was created with the data of the file.
+   */
+  VORTEX_API bool IsLoaded() const;
 
   /**
    * @brief Create a graphics pipeline
@@ -165,7 +192,7 @@ public:
                                                  const RenderState& renderState);
 
   /**
-   * @brief Create a compute pipeline
+   * @brief Create a compute pipeline, waiting for its creation.
    * @param shader
    * @param layout
    * @param specConstInfo
@@ -174,27 +201,90 @@ public:
                                                 vk::PipelineLayout layout,
                                                 SpecConstInfo specConstInfo = {});
 
+  /**
+   * @brief Queue the creation of a compute pipeline on the worker threads.
+   * @param shader
+   * @param layout
+   * @param specConstInfo
+   * @return the pipeline, available once created
+   */
+  VORTEX_API std::shared_future<vk::Pipeline> CreateComputePipelineAsync(
+      vk::ShaderModule shader,
+      vk::PipelineLayout layout,
+      SpecConstInfo specConstInfo = {});
+
+  /**
+   * @brief Wait for all queued compute pipelines to be created.
+   */
+  VORTEX_API void Wait() const;
+
 private:
-  struct GraphicsPipelineCache
+  void WorkerThread();
+
+  struct GraphicsPipelineKey
   {
     RenderState State;
     GraphicsPipeline Graphics;
-    vk::UniquePipeline Pipeline;
+
+    friend bool operator==(const GraphicsPipelineKey& left, const GraphicsPipelineKey& right)
+    {
+      return left.State == right.State && left.Graphics == right.Graphics;
+    }
   };
 
-  struct ComputePipelineCache
+  struct ComputePipelineKey
   {
     vk::ShaderModule Shader;
     vk::PipelineLayout Layout;
     SpecConstInfo SpecConst;
+
+    friend bool operator==(const ComputePipelineKey& left, const ComputePipelineKey& right)
+    {
+      return left.Shader == right.Shader && left.Layout == right.Layout &&
+             left.SpecConst == right.SpecConst;
+    }
+  };
+
+  struct PipelineKeyHash
+  {
+    std::size_t operator()(const GraphicsPipelineKey& key) const;
+    std::size_t operator()(const ComputePipelineKey& key) const;
+  };
+
+  struct ComputePipelineCache
+  {
     vk::UniquePipeline Pipeline;
+    std::shared_future<vk::Pipeline> Future;
   };
 
   const Device& mDevice;
-  std::vector<GraphicsPipelineCache> mGraphicsPipelines;
-  std::vector<ComputePipelineCache> mComputePipelines;
+  std::string mPath;
+  std::unordered_map<GraphicsPipelineKey, vk::UniquePipeline, PipelineKeyHash> mGraphicsPipelines;
+  std::unordered_map<ComputePipelineKey, ComputePipelineCache, PipelineKeyHash> mComputePipelines;
   vk::UniquePipelineCache mCache;
+  bool mLoaded;
+
+  std::mutex mMutex;
+  std::condition_variable mCondition;
+  std::deque<std::function<void()>> mTasks;
+  std::vector<std::thread> mWorkers;
+  bool mStop;
 };
 
 }  // namespace Renderer
 }  // namespace Vortex
+
+namespace std
+{
+template <>
+struct hash<Vortex::Renderer::GraphicsPipeline>
+{
+  VORTEX_API std::size_t operator()(const Vortex::Renderer::GraphicsPipeline& graphics) const;
+};
+
+template <>
+struct hash<Vortex::Renderer::SpecConstInfo>
+{
+  VORTEX_API std::size_t operator()(const Vortex::Renderer::SpecConstInfo& specConstInfo) const;
+};
+}  // namespace std
@@ -0,0 +1,93 @@
+//
+//  PipelineBarrier.cpp
+//  Vortex
+//
+
+#include "PipelineBarrier.h"
+
+#include <Vortex/Renderer/Buffer.h>
+#include <Vortex/Renderer/Texture.h>
+
+namespace Vortex
+{
+namespace Renderer
+{
+PipelineBarrier::PipelineBarrier(vk::PipelineStageFlags srcStage, vk::PipelineStageFlags dstStage)
+    : mSrcStage(srcStage), mDstStage(dstStage)
+{
+}
+
+PipelineBarrier& PipelineBarrier::Add(GenericBuffer& buffer,
+                                      vk::AccessFlags oldAccess,
+                                      vk::AccessFlags newAccess)
+{
+  mBufferBarriers.push_back(vk::BufferMemoryBarrier()
+                                .setSrcQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+                                .setDstQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+                                .setBuffer(buffer.Handle())
+                                .setSize(VK_WHOLE_SIZE)
+                                .setSrcAccessMask(oldAccess)
+                                .setDstAccessMask(newAccess));
+
+  return *this;
+}
+
+PipelineBarrier& PipelineBarrier::Add(Texture& texture,
+                                      vk::ImageLayout oldLayout,
+                                      vk::AccessFlags oldAccess,
+                                      vk::ImageLayout newLayout,
+                                      vk::AccessFlags newAccess)
+{
+  mImageBarriers.push_back(vk::ImageMemoryBarrier()
+                               .setSrcQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+                               .setDstQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+                               .setOldLayout(oldLayout)
+                               .setNewLayout(newLayout)
+                               .setImage(texture.Handle())
+                               .setSubresourceRange({vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1})
+                               .setSrcAccessMask(oldAccess)
+                               .setDstAccessMask(newAccess));
+
+  return *this;
+}
+
+void PipelineBarrier::Record(vk::CommandBuffer commandBuffer) const
+{
+  if (mBufferBarriers.empty() && mImageBarriers.empty())
+  {
+    return;
+  }
+
+  commandBuffer.pipelineBarrier(mSrcStage, mDstStage, {}, nullptr, mBufferBarriers, mImageBarriers);
+}
+
+void ComputeBarrier(vk::CommandBuffer commandBuffer,
+                    std::initializer_list<std::reference_wrapper<GenericBuffer>> buffers)
+{
+  PipelineBarrier barrier;
+  for (auto& buffer : buffers)
+  {
+    barrier.Add(buffer, vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead);
+  }
+
+  barrier.Record(commandBuffer);
+}
+
+void ComputeBarrier(vk::CommandBuffer commandBuffer,
+                    std::initializer_list<std::reference_wrapper<Texture>> textures)
+{
+  PipelineBarrier barrier;
+  for (auto& texture : textures)
+  {
+    barrier.Add(texture,
+                vk::ImageLayout::eGeneral,
+                vk::AccessFlagBits::eShaderWrite,
+                vk::ImageLayout::eGeneral,
+                vk::AccessFlagBits::eShaderRead);
+  }
+
+  barrier.Record(commandBuffer);
+}
+
+}  // namespace Renderer
+}  // namespace Vortex
@@ -0,0 +1,98 @@
+//
+//  PipelineBarrier.h
+//  Vortex
+//
+
+#pragma once
+
+#include <Vortex/Renderer/Common.h>
+
+#include <functional>
+#include <initializer_list>
+#include <vector>
+
+namespace Vortex
+{
+namespace Renderer
+{
+class GenericBuffer;
+class Texture;
+
+/**
+ * @brief Collects buffer and texture barriers between two sets of pipeline
+ * stages, and records them with a single pipeline barrier command.
+ */
+class PipelineBarrier
+{
+public:
+  /**
+   * @brief Create an empty barrier between two sets of pipeline stages. By
+   * default, from compute shader to compute shader.
+   * @param srcStage pipeline stages of the old accesses
+   * @param dstStage pipeline stages of the new accesses
+   */
+  VORTEX_API PipelineBarrier(
+      vk::PipelineStageFlags srcStage = vk::PipelineStageFlagBits::eComputeShader,
+      vk::PipelineStageFlags dstStage = vk::PipelineStageFlagBits::eComputeShader);
+
+  /**
+   * @brief Add a buffer barrier
+   * @param buffer the buffer
+   * @param oldAccess old access
+   * @param newAccess new access
+   * @return *this
+   */
+  VORTEX_API PipelineBarrier& Add(GenericBuffer& buffer,
+                                  vk::AccessFlags oldAccess,
+                                  vk::AccessFlags newAccess);
+
+  /**
+   * @brief Add a texture barrier
+   * @param texture the texture
+   * @param oldLayout old layout
+   * @param oldAccess old access
+   * @param newLayout new layout
+   * @param newAccess new access
+   * @return *this
+   */
+  VORTEX_API PipelineBarrier& Add(Texture& texture,
+                                  vk::ImageLayout oldLayout,
+                                  vk::AccessFlags oldAccess,
+                                  vk::ImageLayout newLayout,
+                                  vk::AccessFlags newAccess);
+
+  /**
+   * @brief Record all the barriers in one pipeline barrier command. Does
+   * nothing if no barriers were added.
+   * @param commandBuffer the command buffer to record into
+   */
+  VORTEX_API void Record(vk::CommandBuffer commandBuffer) const;
+
+private:
+  vk::PipelineStageFlags mSrcStage;
+  vk::PipelineStageFlags mDstStage;
+  std::vector<vk::BufferMemoryBarrier> mBufferBarriers;
+  std::vector<vk::ImageMemoryBarrier> mImageBarriers;
+};
+
+/**
+ * @brief Inserts a single barrier for buffers written by a compute shader and
+ * read by the following compute shaders.
+ * @param commandBuffer the command buffer to record into
+ * @param buffers the buffers written
+ */
+VORTEX_API void ComputeBarrier(
+    vk::CommandBuffer commandBuffer,
+    std::initializer_list<std::reference_wrapper<GenericBuffer>> buffers);
+
+/**
+ * @brief Inserts a single barrier for textures written by a compute shader and
+ * read by the following compute shaders.
+ * @param commandBuffer the command buffer to record into
+ * @param textures the textures written
+ */
+VORTEX_API void ComputeBarrier(vk::CommandBuffer commandBuffer,
+                               std::initializer_list<std::reference_wrapper<Texture>> textures);
+
+}  // namespace Renderer
+}  // namespace Vortex
@@ -0,0 +1,371 @@
+//
+//  Profiler.cpp
+//  Vortex
+//
+
+#include "Profiler.h"
+
+#include <Vortex/Renderer/Device.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+
+namespace Vortex
+{
+namespace Renderer
+{
+namespace
+{
+int64_t Nanoseconds(Profiler::Clock::duration duration)
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+}
+
+std::string Escape(const std::string& name)
+{
+  std::string escaped;
+  for (char c : name)
+  {
+    if (c == '"' || c == '\\')
+    {
+      escaped += '\\';
+    }
+
+    if (static_cast<unsigned char>(c) >= 0x20)
+    {
+      escaped += c;
+    }
+  }
+
+  return escaped;
+}
+
+}  // namespace
+
+Profiler::Profiler(const Device& device, uint32_t maxScopes)
+    : mDevice(device), mTracing(false), mCalibrationQuery(2 * maxScopes), mGpuOffsetNs(0)
+{
+  // the last query is used to align the GPU and CPU clocks
+  auto queryPoolInfo = vk::QueryPoolCreateInfo()
+                           .setQueryType(vk::QueryType::eTimestamp)
+                           .setQueryCount(2 * maxScopes + 1);
+
+  mPool = device.Handle().createQueryPoolUnique(queryPoolInfo);
+
+  for (uint32_t i = maxScopes; i > 0; i--)
+  {
+    mFreeQueries.push_back(2 * (i - 1));
+  }
+
+  auto properties = device.GetPhysicalDevice().getProperties();
+  assert(properties.limits.timestampComputeAndGraphics);
+  mTimestampPeriod = properties.limits.timestampPeriod;
+
+  auto queueProperties = device.GetPhysicalDevice().getQueueFamilyProperties();
+  auto validBits = queueProperties[device.GetFamilyIndex()].timestampValidBits;
+  mTimestampMask = validBits >= 64 ? static_cast<uint64_t>(-1) : (1ull << validBits) - 1;
+
+  device.SetProfiler(this);
+}
+
+Profiler::~Profiler()
+{
+  mDevice.SetProfiler(nullptr);
+}
+
+void Profiler::BeginCommandBuffer(vk::CommandBuffer commandBuffer)
+{
+  // the previous recording of the command buffer is discarded
+  FreeCommandBuffer(commandBuffer);
+}
+
+void Profiler::FreeCommandBuffer(vk::CommandBuffer commandBuffer)
+{
+  auto it = mRecordings.find(commandBuffer);
+  if (it != mRecordings.end())
+  {
+    for (auto& scope : it->second.Scopes)
+    {
+      mFreeQueries.push_back(scope.Query);
+    }
+
+    mRecordings.erase(it);
+  }
+
+  mPending.erase(std::remove(mPending.begin(), mPending.end(), commandBuffer), mPending.end());
+}
+
+void Profiler::BeginScope(vk::CommandBuffer commandBuffer, const char* name)
+{
+  auto& recording = mRecordings[commandBuffer];
+
+  if (mFreeQueries.empty())
+  {
+    recording.Stack.push_back(-1);
+    return;
+  }
+
+  std::string path = name;
+  uint32_t depth = 0;
+  for (auto it = recording.Stack.rbegin(); it != recording.Stack.rend(); ++it)
+  {
+    if (*it != -1)
+    {
+      const auto& parent = mStages[recording.Scopes[*it].Stage];
+      path = parent.Name + "/" + path;
+      depth = parent.Depth + 1;
+      break;
+    }
+  }
+
+  auto stage = mStageIndices.find(path);
+  if (stage == mStageIndices.end())
+  {
+    stage = mStageIndices.emplace(path, mStages.size()).first;
+    mStages.push_back({path, depth, 0, 0});
+  }
+
+  auto query = mFreeQueries.back();
+  mFreeQueries.pop_back();
+
+  recording.Stack.push_back(static_cast<int>(recording.Scopes.size()));
+  recording.Scopes.push_back({stage->second, query, false, 0, 0});
+
+  commandBuffer.resetQueryPool(*mPool, query, 2);
+  commandBuffer.writeTimestamp(vk::PipelineStageFlagBits::eAllCommands, *mPool, query);
+}
+
+void Profiler::EndScope(vk::CommandBuffer commandBuffer)
+{
+  auto it = mRecordings.find(commandBuffer);
+  if (it == mRecordings.end() || it->second.Stack.empty())
+  {
+    return;
+  }
+
+  auto index = it->second.Stack.back();
+  it->second.Stack.pop_back();
+
+  if (index != -1)
+  {
+    auto query = it->second.Scopes[index].Query;
+    commandBuffer.writeTimestamp(vk::PipelineStageFlagBits::eAllCommands, *mPool, query + 1);
+  }
+}
+
+std::vector<Profiler::Stage> Profiler::Resolve()
+{
+  for (auto& stage : mStages)
+  {
+    stage.Count = 0;
+    stage.LastExecutionNs = 0;
+  }
+
+  for (auto& recording : mRecordings)
+  {
+    for (auto& scope : recording.second.Scopes)
+    {
+      uint64_t begin, end;
+      if (ReadTimestamps(scope.Query, begin, end))
+      {
+        scope.ElapsedNs = static_cast<uint64_t>((end - begin) * mTimestampPeriod);
+        scope.Resolved = true;
+      }
+
+      if (scope.Resolved)
+      {
+        mStages[scope.Stage].Count++;
+        mStages[scope.Stage].LastExecutionNs += scope.ElapsedNs;
+      }
+    }
+  }
+
+  return mStages;
+}
+
+void Profiler::BeginTrace()
+{
+  mTracing = false;
+  mEvents.clear();
+  mPending.clear();
+  mThreads.clear();
+  mTraceStart = Clock::now();
+
+  // the GPU timestamp is taken between the CPU times before and after
+  auto before = Clock::now();
+  mDevice.Execute([&](vk::CommandBuffer commandBuffer) {
+    commandBuffer.resetQueryPool(*mPool, mCalibrationQuery, 1);
+    commandBuffer.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe,
+                                 *mPool,
+                                 mCalibrationQuery);
+  });
+  auto after = Clock::now();
+
+  uint64_t timestamp = 0;
+  auto result = mDevice.Handle().getQueryPoolResults(
+      *mPool,
+      mCalibrationQuery,
+      1,
+      sizeof(timestamp),
+      &timestamp,
+      sizeof(timestamp),
+      vk::QueryResultFlagBits::e64 | vk::QueryResultFlagBits::eWait);
+  if (result != vk::Result::eSuccess)
+  {
+    throw std::runtime_error("Failed to read the calibration timestamp");
+  }
+
+  auto gpuNs = static_cast<int64_t>((timestamp & mTimestampMask) * mTimestampPeriod);
+  auto cpuNs = Nanoseconds(before - mTraceStart) + Nanoseconds(after - before) / 2;
+  mGpuOffsetNs = cpuNs - gpuNs;
+  mTracing = true;
+}
+
+void Profiler::EndTrace(const std::string& path)
+{
+  mTracing = false;
+
+  std::ofstream file(path, std::ios::trunc);
+  if (!file)
+  {
+    throw std::runtime_error("Cannot open trace file " + path);
+  }
+
+  // times are in microseconds, thread 0 is the GPU queue
+  file << std::fixed << std::setprecision(3);
+  file << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+  file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,"
+       << "\"args\":{\"name\":\"GPU\"}}";
+
+  for (auto& thread : mThreads)
+  {
+    file << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << thread.second
+         << ",\"args\":{\"name\":\"CPU " << thread.second << "\"}}";
+  }
+
+  for (auto& event : mEvents)
+  {
+    file << ",\n{\"name\":\"" << Escape(event.Name) << "\",\"cat\":\""
+         << (event.Thread == 0 ? "gpu" : "cpu") << "\",\"ph\":\"X\",\"pid\":1,\"tid\":"
+         << event.Thread << ",\"ts\":" << event.StartNs / 1000.0
+         << ",\"dur\":" << event.DurationNs / 1000.0 << "}";
+  }
+
+  file << "\n]}\n";
+
+  mEvents.clear();
+  mPending.clear();
+}
+
+void Profiler::Submit(vk::CommandBuffer commandBuffer, Clock::time_point start)
+{
+  if (!mTracing)
+  {
+    return;
+  }
+
+  AddEvent("Submit", start);
+
+  if (std::find(mPending.begin(), mPending.end(), commandBuffer) == mPending.end())
+  {
+    mPending.push_back(commandBuffer);
+  }
+}
+
+void Profiler::Wait(Clock::time_point start)
+{
+  if (!mTracing)
+  {
+    return;
+  }
+
+  AddEvent("Wait", start);
+
+  // a fence signal happens after all the previous submits to the queue
+  for (auto commandBuffer : mPending)
+  {
+    TraceScopes(commandBuffer);
+  }
+
+  mPending.clear();
+}
+
+void Profiler::AddEvent(const char* name, Clock::time_point start)
+{
+  if (!mTracing)
+  {
+    return;
+  }
+
+  auto end = Clock::now();
+  mEvents.push_back({name,
+                     GetThread(),
+                     Nanoseconds(start - mTraceStart),
+                     static_cast<uint64_t>(Nanoseconds(end - start))});
+}
+
+bool Profiler::ReadTimestamps(uint32_t query, uint64_t& begin, uint64_t& end)
+{
+  // timestamp and availability of the begin and end queries
+  uint64_t results[4] = {0};
+  auto result = mDevice.Handle().getQueryPoolResults(
+      *mPool,
+      query,
+      2,
+      sizeof(results),
+      results,
+      2 * sizeof(uint64_t),
+      vk::QueryResultFlagBits::e64 | vk::QueryResultFlagBits::eWithAvailability);
+
+  if (result != vk::Result::eSuccess || results[1] == 0 || results[3] == 0)
+  {
+    return false;
+  }
+
+  begin = results[0] & mTimestampMask;
+  end = results[2] & mTimestampMask;
+  return true;
+}
+
+uint32_t Profiler::GetThread()
+{
+  auto it = mThreads.find(std::this_thread::get_id());
+  if (it == mThreads.end())
+  {
+    auto thread = static_cast<uint32_t>(mThreads.size() + 1);
+    it = mThreads.emplace(std::this_thread::get_id(), thread).first;
+  }
+
+  return it->second;
+}
+
+void Profiler::TraceScopes(vk::CommandBuffer commandBuffer)
+{
+  auto it = mRecordings.find(commandBuffer);
+  if (it == mRecordings.end())
+  {
+    return;
+  }
+
+  for (auto& scope : it->second.Scopes)
+  {
+    // skip scopes which were not executed again since the last trace
+    uint64_t begin, end;
+    if (!ReadTimestamps(scope.Query, begin, end) || begin == scope.TracedBegin)
+    {
+      continue;
+    }
+
+    scope.TracedBegin = begin;
+
+    const auto& name = mStages[scope.Stage].Name;
+    mEvents.push_back({name.substr(name.rfind('/') + 1),
+                       0,
+                       static_cast<int64_t>(begin * mTimestampPeriod) + mGpuOffsetNs,
+                       static_cast<uint64_t>((end - begin) * mTimestampPeriod)});
+  }
+}
+
+}  // namespace Renderer
+}  // namespace Vortex
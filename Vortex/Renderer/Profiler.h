@@ -0,0 +1,147 @@
+//
+//  Profiler.h
+//  Vortex
+//
+
+#pragma once
+
+#include <Vortex/Renderer/Common.h>
+
+#include <chrono>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace Vortex
+{
+namespace Renderer
+{
+class Device;
+
+/**
+ * @brief Measures the GPU time of the debug marker scopes recorded in command
+ * buffers, e.g. "PCG Step" or "Particle scan". While the profiler exists, each
+ * scope writes timestamps in a query pool, which are read back later without
+ * waiting on the GPU. Profiled scopes must be recorded outside render passes.
+ * The profiler can also record a timeline of the command buffer submits, fence
+ * waits and GPU scopes, which is written as a Chrome trace file.
+ */
+class Profiler
+{
+public:
+  /**
+   * @brief The GPU time of all the scopes with the same name and the same
+   * parent scopes. The timestamps of a scope are overwritten each time its
+   * command buffer is executed, so a command buffer submitted several times,
+   * e.g. the linear solver iterations, only gives the time of its last
+   * execution.
+   */
+  struct Stage
+  {
+    std::string Name;
+    uint32_t Depth;
+    /**
+     * @brief Number of recorded scopes, not of executions.
+     */
+    uint32_t Count;
+    /**
+     * @brief Sum of the time of the last execution of each scope.
+     */
+    uint64_t LastExecutionNs;
+  };
+
+  /**
+   * @brief Create the profiler and attach it to the device.
+   * @param device vulkan device
+   * @param maxScopes maximum number of scopes recorded at the same time
+   */
+  VORTEX_API Profiler(const Device& device, uint32_t maxScopes = 1024);
+  VORTEX_API ~Profiler();
+
+  Profiler(Profiler&&) = delete;
+  Profiler& operator=(Profiler&&) = delete;
+
+  /**
+   * @brief Read the timestamps of the scopes which finished executing. Does
+   * not wait on the GPU, scopes which didn't finish keep their previous time.
+   * @return the time of the last execution of each stage, in the order they
+   * were first recorded.
+   * Names of nested stages are prefixed with the name of their parents.
+   */
+  VORTEX_API std::vector<Stage> Resolve();
+
+  /**
+   * @brief Start recording a timeline of the CPU and GPU events. Any previous
+   * timeline is discarded. Waits on the device to align the GPU clock with the
+   * CPU clock.
+   */
+  VORTEX_API void BeginTrace();
+
+  /**
+   * @brief Stop recording the timeline and write it as a Chrome trace JSON
+   * file, which can be opened in chrome://tracing or Perfetto. The GPU scopes
+   * of a command buffer are read once a fence wait completes, if the command
+   * buffer was submitted several times before, only the last submit is traced.
+   * @param path file of the trace
+   */
+  VORTEX_API void EndTrace(const std::string& path);
+
+  using Clock = std::chrono::steady_clock;
+
+  void BeginCommandBuffer(vk::CommandBuffer commandBuffer);
+  void FreeCommandBuffer(vk::CommandBuffer commandBuffer);
+  void BeginScope(vk::CommandBuffer commandBuffer, const char* name);
+  void EndScope(vk::CommandBuffer commandBuffer);
+  void Submit(vk::CommandBuffer commandBuffer, Clock::time_point start);
+  void Wait(Clock::time_point start);
+  void AddEvent(const char* name, Clock::time_point start);
+
+private:
+  struct Scope
+  {
+    std::size_t Stage;
+    uint32_t Query;
+    bool Resolved;
+    uint64_t ElapsedNs;
+    uint64_t TracedBegin;
+  };
+
+  struct Event
+  {
+    std::string Name;
+    uint32_t Thread;
+    int64_t StartNs;
+    uint64_t DurationNs;
+  };
+
+  bool ReadTimestamps(uint32_t query, uint64_t& begin, uint64_t& end);
+  uint32_t GetThread();
+  void TraceScopes(vk::CommandBuffer commandBuffer);
+
+  struct Recording
+  {
+    std::vector<Scope> Scopes;
+    std::vector<int> Stack;
+  };
+
+  const Device& mDevice;
+  vk::UniqueQueryPool mPool;
+  std::vector<uint32_t> mFreeQueries;
+  std::map<vk::CommandBuffer, Recording> mRecordings;
+  std::vector<Stage> mStages;
+  std::map<std::string, std::size_t> mStageIndices;
+  uint64_t mTimestampMask;
+  double mTimestampPeriod;
+
+  bool mTracing;
+  uint32_t mCalibrationQuery;
+  Clock::time_point mTraceStart;
+  int64_t mGpuOffsetNs;
+  std::vector<Event> mEvents;
+  std::vector<vk::CommandBuffer> mPending;
+  std::map<std::thread::id, uint32_t> mThreads;
+};
+
+}  // namespace Renderer
+}  // namespace Vortex
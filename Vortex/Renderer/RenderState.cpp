@@ -37,3 +37,33 @@ bool operator==(const RenderState& left, const RenderState right)
 
 }  // namespace Renderer
 }  // namespace Vortex
+
+namespace std
+{
+std::size_t hash<Vortex::Renderer::RenderState>::operator()(
+    const Vortex::Renderer::RenderState& renderState) const
+{
+  using Vortex::Renderer::HashCombine;
+
+  const auto& colorBlend = renderState.BlendState.ColorBlend;
+
+  std::size_t seed = 0;
+  HashCombine(seed, renderState.Width);
+  HashCombine(seed, renderState.Height);
+  HashCombine(seed, static_cast<VkRenderPass>(renderState.RenderPass));
+  HashCombine(seed, static_cast<VkBool32>(colorBlend.blendEnable));
+  HashCombine(seed, static_cast<int>(colorBlend.srcColorBlendFactor));
+  HashCombine(seed, static_cast<int>(colorBlend.dstColorBlendFactor));
+  HashCombine(seed, static_cast<int>(colorBlend.colorBlendOp));
+  HashCombine(seed, static_cast<int>(colorBlend.srcAlphaBlendFactor));
+  HashCombine(seed, static_cast<int>(colorBlend.dstAlphaBlendFactor));
+  HashCombine(seed, static_cast<int>(colorBlend.alphaBlendOp));
+  HashCombine(seed, static_cast<VkColorComponentFlags>(colorBlend.colorWriteMask));
+  for (auto constant : renderState.BlendState.BlendConstants)
+  {
+    HashCombine(seed, constant);
+  }
+
+  return seed;
+}
+}  // namespace std
@@ -52,3 +52,12 @@ bool operator==(const RenderState& left, const RenderState right);
 
 }  // namespace Renderer
 }  // namespace Vortex
+
+namespace std
+{
+template <>
+struct hash<Vortex::Renderer::RenderState>
+{
+  VORTEX_API std::size_t operator()(const Vortex::Renderer::RenderState& renderState) const;
+};
+}  // namespace std
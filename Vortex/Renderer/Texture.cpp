@@ -354,6 +354,17 @@ void Texture::Barrier(vk::CommandBuffer commandBuffer,
   TextureBarrier(mImage, commandBuffer, oldLayout, srcMask, newLayout, dstMask);
 }
 
+void Texture::Barrier(vk::CommandBuffer commandBuffer,
+                      vk::PipelineStageFlags srcStage,
+                      vk::ImageLayout oldLayout,
+                      vk::AccessFlags srcMask,
+                      vk::PipelineStageFlags dstStage,
+                      vk::ImageLayout newLayout,
+                      vk::AccessFlags dstMask)
+{
+  TextureBarrier(mImage, commandBuffer, srcStage, oldLayout, srcMask, dstStage, newLayout, dstMask);
+}
+
 vk::ImageView Texture::GetView() const
 {
   return *mImageView;
@@ -385,6 +396,25 @@ void TextureBarrier(vk::Image image,
                     vk::AccessFlags srcMask,
                     vk::ImageLayout newLayout,
                     vk::AccessFlags dstMask)
+{
+  TextureBarrier(image,
+                 commandBuffer,
+                 vk::PipelineStageFlagBits::eAllCommands | vk::PipelineStageFlagBits::eHost,
+                 oldLayout,
+                 srcMask,
+                 vk::PipelineStageFlagBits::eAllCommands | vk::PipelineStageFlagBits::eHost,
+                 newLayout,
+                 dstMask);
+}
+
+void TextureBarrier(vk::Image image,
+                    vk::CommandBuffer commandBuffer,
+                    vk::PipelineStageFlags srcStage,
+                    vk::ImageLayout oldLayout,
+                    vk::AccessFlags srcMask,
+                    vk::PipelineStageFlags dstStage,
+                    vk::ImageLayout newLayout,
+                    vk::AccessFlags dstMask)
 {
   auto imageMemoryBarriers = vk::ImageMemoryBarrier()
                                  .setSrcQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
@@ -396,13 +426,7 @@ void TextureBarrier(vk::Image image,
                                  .setSrcAccessMask(srcMask)
                                  .setDstAccessMask(dstMask);
 
-  commandBuffer.pipelineBarrier(
-      vk::PipelineStageFlagBits::eAllCommands | vk::PipelineStageFlagBits::eHost,
-      vk::PipelineStageFlagBits::eAllCommands | vk::PipelineStageFlagBits::eHost,
-      {},
-      nullptr,
-      nullptr,
-      imageMemoryBarriers);
+  commandBuffer.pipelineBarrier(srcStage, dstStage, {}, nullptr, nullptr, imageMemoryBarriers);
 }
 
 }  // namespace Renderer
@@ -114,6 +114,24 @@ public:
                           vk::ImageLayout newLayout,
                           vk::AccessFlags newAccess);
 
+  /**
+   * @brief Inserts a barrier for this texture between specific pipeline stages
+   * @param commandBuffer vulkan command buffer
+   * @param srcStage pipeline stages of the old access
+   * @param oldLayout old layout
+   * @param oldAccess old access
+   * @param dstStage pipeline stages of the new access
+   * @param newLayout new layout
+   * @param newAccess new access
+   */
+  VORTEX_API void Barrier(vk::CommandBuffer commandBuffer,
+                          vk::PipelineStageFlags srcStage,
+                          vk::ImageLayout oldLayout,
+                          vk::AccessFlags oldAccess,
+                          vk::PipelineStageFlags dstStage,
+                          vk::ImageLayout newLayout,
+                          vk::AccessFlags newAccess);
+
   VORTEX_API vk::ImageView GetView() const;
   VORTEX_API uint32_t GetWidth() const;
   VORTEX_API uint32_t GetHeight() const;
@@ -154,5 +172,26 @@ VORTEX_API void TextureBarrier(vk::Image image,
                                vk::ImageLayout newLayout,
                                vk::AccessFlags dstMask);
 
+/**
+ * @brief Inserts a barrier for the given texture, command buffer, pipeline
+ * stages and access.
+ * @param image the vulkan image handle
+ * @param commandBuffer the vulkan command buffer
+ * @param srcStage pipeline stages of the old access
+ * @param oldLayout old layout
+ * @param srcMask old access
+ * @param dstStage pipeline stages of the new access
+ * @param newLayout new layout
+ * @param dstMask new access
+ */
+VORTEX_API void TextureBarrier(vk::Image image,
+                               vk::CommandBuffer commandBuffer,
+                               vk::PipelineStageFlags srcStage,
+                               vk::ImageLayout oldLayout,
+                               vk::AccessFlags srcMask,
+                               vk::PipelineStageFlags dstStage,
+                               vk::ImageLayout newLayout,
+                               vk::AccessFlags dstMask);
+
 }  // namespace Renderer
 }  // namespace Vortex
@@ -22,7 +22,7 @@ uint64_t GetMask(uint32_t validBits)
   }
   else
   {
-    return (1 << validBits) - 1;
+    return (1ull << validBits) - 1;
   }
 }
 }  // namespace
@@ -89,12 +89,13 @@ uint64_t Timer::GetElapsedNs()
     auto properties = mDevice.GetPhysicalDevice().getProperties();
     assert(properties.limits.timestampComputeAndGraphics);
 
-    uint64_t period = static_cast<uint64_t>(properties.limits.timestampPeriod);
+    double period = properties.limits.timestampPeriod;
 
     auto queueProperties = mDevice.GetPhysicalDevice().getQueueFamilyProperties();
     auto validBits = queueProperties[familyIndex].timestampValidBits;
 
-    return ((timestamps[1] & GetMask(validBits)) - (timestamps[0] & GetMask(validBits))) * period;
+    auto elapsed = (timestamps[1] & GetMask(validBits)) - (timestamps[0] & GetMask(validBits));
+    return static_cast<uint64_t>(elapsed * period);
   }
   else
   {
@@ -6,6 +6,7 @@
 #include "Work.h"
 
 #include <Vortex/Renderer/DescriptorSet.h>
+#include <Vortex/Renderer/LocalSizeTuner.h>
 #include <Vortex/SPIRV/Reflection.h>
 
 namespace Vortex
@@ -33,15 +34,47 @@ glm::ivec2 ComputeSize::GetWorkSize(int size, int localSize)
 }
 
 ComputeSize::ComputeSize(const glm::ivec2& size, const glm::ivec2& localSize)
-    : DomainSize(size), WorkSize(GetWorkSize(size, localSize)), LocalSize(localSize)
+    : DomainSize(size)
+    , WorkSize(GetWorkSize(size, localSize))
+    , LocalSize(localSize)
+    , WorkShape(localSize == GetLocalSize2D() ? Shape::Grid : Shape::Fixed)
+    , StencilRadius(0)
 {
 }
 
 ComputeSize::ComputeSize(int size, int localSize)
-    : DomainSize({size, 1}), WorkSize(GetWorkSize(size, localSize)), LocalSize({localSize, 1})
+    : DomainSize({size, 1})
+    , WorkSize(GetWorkSize(size, localSize))
+    , LocalSize({localSize, 1})
+    , WorkShape(Shape::Fixed)
+    , StencilRadius(0)
 {
 }
 
+ComputeSize ComputeSize::WithLocalSize(const glm::ivec2& localSize) const
+{
+  ComputeSize computeSize(*this);
+  switch (WorkShape)
+  {
+    case Shape::Fixed:
+      return computeSize;
+    case Shape::Grid:
+      computeSize.WorkSize = GetWorkSize(DomainSize, localSize);
+      break;
+    case Shape::Stencil:
+      computeSize.WorkSize = glm::ceil(glm::vec2(DomainSize) /
+                                       glm::vec2(localSize - glm::ivec2(2 * StencilRadius)));
+      break;
+    case Shape::Checkerboard:
+      computeSize.WorkSize =
+          glm::ceil(glm::vec2(DomainSize) / (glm::vec2(localSize) * glm::vec2(2.0f, 1.0f)));
+      break;
+  }
+
+  computeSize.LocalSize = localSize;
+  return computeSize;
+}
+
 ComputeSize ComputeSize::Default2D()
 {
   return ComputeSize(glm::ivec2{1});
@@ -54,14 +87,11 @@ ComputeSize ComputeSize::Default1D()
 
 ComputeSize MakeStencilComputeSize(const glm::ivec2& size, int radius)
 {
-  ComputeSize computeSize(ComputeSize::Default2D());
+  ComputeSize computeSize(size);
+  computeSize.WorkShape = ComputeSize::Shape::Stencil;
+  computeSize.StencilRadius = radius;
 
-  auto localSize = ComputeSize::GetLocalSize2D();
-  computeSize.DomainSize = size;
-  computeSize.LocalSize = localSize;
-  computeSize.WorkSize = glm::ceil(glm::vec2(size) / glm::vec2(localSize - glm::ivec2(2 * radius)));
-
-  return computeSize;
+  return computeSize.WithLocalSize(ComputeSize::GetLocalSize2D());
 }
 
 ComputeSize MakeCheckerboardComputeSize(const glm::ivec2& size)
@@ -70,13 +100,10 @@ ComputeSize MakeCheckerboardComputeSize(const glm::ivec2& size)
   localSize.x /= 2;
   localSize.y *= 2;
 
-  ComputeSize computeSize(ComputeSize::Default2D());
-  computeSize.DomainSize = size;
-  computeSize.LocalSize = localSize;
-  computeSize.WorkSize =
-      glm::ceil(glm::vec2(size) / (glm::vec2(localSize) * glm::vec2(2.0f, 1.0f)));
+  ComputeSize computeSize(size);
+  computeSize.WorkShape = ComputeSize::Shape::Checkerboard;
 
-  return computeSize;
+  return computeSize.WithLocalSize(localSize);
 }
 
 DispatchParams::DispatchParams(int count)
@@ -92,17 +119,40 @@ Work::Work(const Device& device,
            const ComputeSize& computeSize,
            const SpirvBinary& spirv,
            const SpecConstInfo& additionalSpecConstInfo)
-    : mComputeSize(computeSize), mDevice(device)
+    : mComputeSize(computeSize)
+    , mDevice(device)
+    , mShaderModule(device.GetShaderModule(spirv))
+    , mSpecConstInfo(additionalSpecConstInfo)
+    , mShader(HashSpirv(spirv.data(), spirv.words()))
+    , mBound(false)
 {
-  vk::ShaderModule shaderModule = device.GetShaderModule(spirv);
   SPIRV::Reflection reflection(spirv);
   if (reflection.GetShaderStage() != vk::ShaderStageFlagBits::eCompute)
     throw std::runtime_error("only compute supported");
 
   mPipelineLayout = {{reflection}};
-  auto layout = device.GetLayoutManager().GetPipelineLayout(mPipelineLayout);
 
-  SpecConstInfo specConstInfo = additionalSpecConstInfo;
+  glm::ivec2 localSize;
+  if (IsTunable() && device.GetLocalSizeTuner().Find(mShader, mComputeSize, localSize))
+  {
+    mComputeSize = mComputeSize.WithLocalSize(localSize);
+  }
+
+  CreatePipeline();
+}
+
+bool Work::IsTunable() const
+{
+  // default compute sizes are overriden when binding, and don't have a domain to tune for
+  return mComputeSize.WorkShape != ComputeSize::Shape::Fixed &&
+         mComputeSize.DomainSize != glm::ivec2(1);
+}
+
+void Work::CreatePipeline()
+{
+  auto layout = mDevice.GetLayoutManager().GetPipelineLayout(mPipelineLayout);
+
+  SpecConstInfo specConstInfo = mSpecConstInfo;
 
   assert(mComputeSize.LocalSize.x > 0 && mComputeSize.LocalSize.y > 0);
   if (mComputeSize.LocalSize.y != 1)
@@ -112,14 +162,14 @@ Work::Work(const Device& device,
                             SpecConstValue(2, mComputeSize.LocalSize.y));
 
     mPipeline =
-        device.GetPipelineCache().CreateComputePipeline(shaderModule, layout, specConstInfo);
+        mDevice.GetPipelineCache().CreateComputePipelineAsync(mShaderModule, layout, specConstInfo);
   }
   else
   {
     Detail::InsertSpecConst(specConstInfo, SpecConstValue(1, mComputeSize.LocalSize.x));
 
     mPipeline =
-        device.GetPipelineCache().CreateComputePipeline(shaderModule, layout, specConstInfo);
+        mDevice.GetPipelineCache().CreateComputePipelineAsync(mShaderModule, layout, specConstInfo);
   }
 }
 
@@ -133,6 +183,46 @@ Work::Bound Work::Bind(ComputeSize computeSize, const std::vector<Renderer::Bind
   auto descriptorSet = mDevice.GetLayoutManager().MakeDescriptorSet(mPipelineLayout);
   Renderer::Bind(mDevice, descriptorSet, mPipelineLayout, inputs);
 
+  // tune with the first bound buffers and textures, which are overwritten. They
+  // must have the domain size of the work, as it's the one pushed by the tuner.
+  auto& tuner = mDevice.GetLocalSizeTuner();
+  glm::ivec2 localSize;
+  if (!mBound && IsTunable() && tuner.IsTuning() &&
+      computeSize.DomainSize == mComputeSize.DomainSize &&
+      !tuner.Find(mShader, mComputeSize, localSize))
+  {
+    localSize = tuner.Tune(mShader,
+                           mComputeSize,
+                           mShaderModule,
+                           descriptorSet.pipelineLayout,
+                           mSpecConstInfo,
+                           mPipelineLayout.layouts.front().pushConstantSize,
+                           *descriptorSet.descriptorSet);
+
+    if (localSize != mComputeSize.LocalSize)
+    {
+      mComputeSize = mComputeSize.WithLocalSize(localSize);
+      CreatePipeline();
+    }
+  }
+  mBound = true;
+
+  // the pipeline is specialised for the tuned local size, the group size of a
+  // fixed compute size is calculated again so it still covers its domain.
+  if (IsTunable() && computeSize.LocalSize != mComputeSize.LocalSize)
+  {
+    if (computeSize.WorkShape == ComputeSize::Shape::Fixed)
+    {
+      computeSize.WorkSize =
+          ComputeSize::GetWorkSize(computeSize.DomainSize, mComputeSize.LocalSize);
+      computeSize.LocalSize = mComputeSize.LocalSize;
+    }
+    else
+    {
+      computeSize = computeSize.WithLocalSize(mComputeSize.LocalSize);
+    }
+  }
+
   return Bound(computeSize,
                mPipelineLayout.layouts.front().pushConstantSize,
                descriptorSet.pipelineLayout,
@@ -145,15 +235,13 @@ Work::Bound Work::Bind(const std::vector<BindingInput>& inputs)
   return Bind(mComputeSize, inputs);
 }
 
-Work::Bound::Bound() : mComputeSize(ComputeSize::Default2D()), mLayout(nullptr), mPipeline(nullptr)
-{
-}
+Work::Bound::Bound() : mComputeSize(ComputeSize::Default2D()), mLayout(nullptr) {}
 
 Work::Bound::Bound(const ComputeSize& computeSize,
                    uint32_t pushConstantSize,
                    vk::PipelineLayout layout,
-                   vk::Pipeline pipeline,
-                   vk::UniqueDescriptorSet descriptor)
+                   std::shared_future<vk::Pipeline> pipeline,
+                   PooledDescriptorSet descriptor)
     : mComputeSize(computeSize)
     , mPushConstantSize(pushConstantSize)
     , mLayout(layout)
@@ -171,7 +259,7 @@ void Work::Bound::Record(vk::CommandBuffer commandBuffer)
   }
 
   commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, mLayout, 0, {*mDescriptor}, {});
-  commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, mPipeline);
+  commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, mPipeline.get());
 
   commandBuffer.dispatch(mComputeSize.WorkSize.x, mComputeSize.WorkSize.y, 1);
 }
@@ -185,7 +273,7 @@ void Work::Bound::RecordIndirect(vk::CommandBuffer commandBuffer,
     PushConstantOffset(commandBuffer, 4, mComputeSize.DomainSize.y);
   }
   commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, mLayout, 0, {*mDescriptor}, {});
-  commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, mPipeline);
+  commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, mPipeline.get());
 
   commandBuffer.dispatchIndirect(dispatchParams.Handle(), 0);
 }
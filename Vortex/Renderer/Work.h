@@ -22,6 +22,18 @@ namespace Renderer
  */
 struct ComputeSize
 {
+  /**
+   * @brief How the group size is calculated from the domain size and local
+   * size. Only the local size of the non fixed ones is tuned.
+   */
+  enum class Shape
+  {
+    Fixed,
+    Grid,
+    Stencil,
+    Checkerboard,
+  };
+
   /**
    * @brief The default local size for 2D compute shaders
    * @return a 2d vector
@@ -81,9 +93,19 @@ struct ComputeSize
    */
   VORTEX_API ComputeSize(int size, int localSize = GetLocalSize1D());
 
+  /**
+   * @brief The same compute size with another local size, the group size is
+   * calculated again. Fixed compute sizes are returned unchanged.
+   * @param localSize the new local size
+   * @return the new compute size
+   */
+  VORTEX_API ComputeSize WithLocalSize(const glm::ivec2& localSize) const;
+
   glm::ivec2 DomainSize;
   glm::ivec2 WorkSize;
   glm::ivec2 LocalSize;
+  Shape WorkShape;
+  int StencilRadius;
 };
 
 /**
@@ -120,7 +142,9 @@ class Work
 public:
   /**
    * @brief Constructs an object using a SPIRV binary. It is not bound to any
-   * buffers or textures.
+   * buffers or textures. The pipeline is created on a worker thread and only
+   * waited for when first recorded. The local size is the one tuned by the
+   * device's @ref LocalSizeTuner, if any.
    * @param device vulkan device
    * @param computeSize the compute size. Can be a default one with size (1,1)
    * or one with an actual size.
@@ -176,8 +200,8 @@ public:
     Bound(const ComputeSize& computeSize,
           uint32_t pushConstantSize,
           vk::PipelineLayout layout,
-          vk::Pipeline pipeline,
-          vk::UniqueDescriptorSet descriptor);
+          std::shared_future<vk::Pipeline> pipeline,
+          PooledDescriptorSet descriptor);
 
     template <typename Arg>
     void PushConstantOffset(vk::CommandBuffer commandBuffer, uint32_t offset, Arg&& arg)
@@ -206,8 +230,8 @@ public:
     ComputeSize mComputeSize;
     uint32_t mPushConstantSize;
     vk::PipelineLayout mLayout;
-    vk::Pipeline mPipeline;
-    vk::UniqueDescriptorSet mDescriptor;
+    std::shared_future<vk::Pipeline> mPipeline;
+    PooledDescriptorSet mDescriptor;
   };
 
   /**
@@ -227,10 +251,17 @@ public:
   VORTEX_API Bound Bind(ComputeSize computeSize, const std::vector<BindingInput>& inputs);
 
 private:
+  bool IsTunable() const;
+  void CreatePipeline();
+
   ComputeSize mComputeSize;
   const Device& mDevice;
   Renderer::PipelineLayout mPipelineLayout;
-  vk::Pipeline mPipeline;
+  std::shared_future<vk::Pipeline> mPipeline;
+  vk::ShaderModule mShaderModule;
+  SpecConstInfo mSpecConstInfo;
+  uint64_t mShader;
+  bool mBound;
 };
 
 }  // namespace Renderer
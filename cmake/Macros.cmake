@@ -23,7 +23,11 @@ set(vortex_macro__internal_dir ${CMAKE_CURRENT_LIST_DIR} CACHE INTERNAL "")
 
 # Function to compile the shaders and generate a C++ source file to include
 function(compile_shader)
-    cmake_parse_arguments(SHADER "" "OUTPUT;VERSION" "SOURCES" ${ARGN})
+    cmake_parse_arguments(SHADER "" "OUTPUT;VERSION;NAMESPACE" "SOURCES" ${ARGN})
+
+    if (NOT DEFINED SHADER_NAMESPACE)
+      set(SHADER_NAMESPACE "SPIRV")
+    endif()
 
     if (NOT DEFINED GLSL_VALIDATOR)
       vortex_find_program(GLSL_VALIDATOR glslangValidator hints "$ENV{VULKAN_SDK}/Bin" "$ENV{VULKAN_SDK}/bin")
@@ -37,7 +41,7 @@ function(compile_shader)
     set(COMPILE_SCRIPT ${vortex_macro__internal_dir}/../Scripts/GenerateSPIRV.py)
     add_custom_command(
        OUTPUT "${SHADER_OUTPUT}.h" "${SHADER_OUTPUT}.cpp"
-       COMMAND ${PYTHON_EXECUTABLE} ${COMPILE_SCRIPT} --compiler ${GLSL_VALIDATOR} --vulkan_version ${SHADER_VERSION} --output ${SHADER_OUTPUT} ${SHADER_SOURCES}
+       COMMAND ${PYTHON_EXECUTABLE} ${COMPILE_SCRIPT} --compiler ${GLSL_VALIDATOR} --vulkan_version ${SHADER_VERSION} --output ${SHADER_OUTPUT} --namespace ${SHADER_NAMESPACE} ${SHADER_SOURCES}
        DEPENDS ${SHADER_SOURCES} ${COMPILE_SCRIPT})
 endfunction()
 